@@ -0,0 +1,286 @@
+// Logger against the naive alternatives on identical record mixes.
+//
+//   bench_baseline [--records N] [--json file]
+//
+// Each mix is formatted by Logger, snprintf into a buffer, std::ostringstream
+// and hand-written std::to_chars, all producing the same field layout
+// (NUL-terminated text fields, raw blobs). Reports ns/record and
+// bytes/record per implementation and mix.
+
+#include "bench_common.hpp"
+
+#include "log_buffer/logger.hpp"
+
+#include <charconv>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#include <ios>
+#include <memory>
+#include <sstream>
+#include <string_view>
+
+using namespace log_buffer;
+
+namespace {
+
+constexpr std::size_t kBufferSize = 64 * 1024;
+constexpr std::size_t kMaxRecordSize = 256;
+
+constexpr std::string_view kUser = "user42";
+constexpr std::string_view kMessage = "login accepted from gateway";
+constexpr uint8_t kBlob[16] = {0xDE, 0xAD, 0xBE, 0xEF, 0x00, 0x01, 0x02, 0x03,
+                               0x10, 0x20, 0x30, 0x40, 0x7F, 0x80, 0xFE, 0xFF};
+
+/// Record mixes; every implementation writes the same fields for a given mix.
+enum class Mix { Strings, Dec, Hex, HEX, Oct, Blob, Mixed };
+
+constexpr Mix kMixes[] = {Mix::Strings, Mix::Dec, Mix::Hex, Mix::HEX, Mix::Oct, Mix::Blob, Mix::Mixed};
+
+const char* mix_name(Mix mix) {
+    switch (mix) {
+        case Mix::Strings: return "strings";
+        case Mix::Dec: return "int_dec";
+        case Mix::Hex: return "int_hex";
+        case Mix::HEX: return "int_HEX";
+        case Mix::Oct: return "int_oct";
+        case Mix::Blob: return "blob";
+        case Mix::Mixed: return "mixed";
+    }
+    return "unknown";
+}
+
+/// Varying values so nothing is constant-folded.
+inline int64_t value_for(uint64_t i) noexcept {
+    return static_cast<int64_t>(i * 2654435761u) - (1 << 30);
+}
+
+struct LoggerWriter {
+    std::unique_ptr<uint8_t[]> storage{new uint8_t[kBufferSize]};
+    Logger logger{storage.get(), kBufferSize};
+
+    inline void ints(int64_t v, IntFormat format) {
+        logger.set_int_format(format);
+        logger.log(v);
+        logger.log(static_cast<uint32_t>(v));
+    }
+
+    inline std::size_t record(Mix mix, uint64_t i) {
+        if (logger.remaining_capacity() < kMaxRecordSize) {
+            logger.reset();
+        }
+        const std::size_t before = logger.bytes_written();
+        const int64_t v = value_for(i);
+        switch (mix) {
+            case Mix::Strings: logger.log(kUser); logger.log(kMessage); break;
+            case Mix::Dec: ints(v, IntFormat::Dec); break;
+            case Mix::Hex: ints(v, IntFormat::Hex); break;
+            case Mix::HEX: ints(v, IntFormat::HEX); break;
+            case Mix::Oct: ints(v, IntFormat::Oct); break;
+            case Mix::Blob: logger.log(kBlob, sizeof(kBlob)); break;
+            case Mix::Mixed:
+                logger.log(kUser);
+                logger.log(kMessage);
+                ints(v, IntFormat::Dec);
+                ints(v, IntFormat::Hex);
+                logger.log(kBlob, sizeof(kBlob));
+                break;
+        }
+        return logger.bytes_written() - before;
+    }
+};
+
+struct SnprintfWriter {
+    std::unique_ptr<char[]> storage{new char[kBufferSize]};
+    std::size_t position = 0;
+
+    inline void text(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        const int n = std::vsnprintf(storage.get() + position, kBufferSize - position, format, args);
+        va_end(args);
+        position += static_cast<std::size_t>(n) + 1;
+    }
+
+    inline void ints(int64_t v, IntFormat format) {
+        const uint32_t u = static_cast<uint32_t>(v);
+        switch (format) {
+            case IntFormat::Dec: text("%" PRId64, v); text("%" PRIu32, u); break;
+            case IntFormat::Hex: text("%s0x%" PRIx64, v < 0 ? "-" : "", static_cast<uint64_t>(v < 0 ? -v : v));
+                                 text("0x%" PRIx32, u); break;
+            case IntFormat::HEX: text("%s0X%" PRIX64, v < 0 ? "-" : "", static_cast<uint64_t>(v < 0 ? -v : v));
+                                 text("0X%" PRIX32, u); break;
+            case IntFormat::Oct: text("%s0%" PRIo64, v < 0 ? "-" : "", static_cast<uint64_t>(v < 0 ? -v : v));
+                                 text("0%" PRIo32, u); break;
+        }
+    }
+
+    inline std::size_t record(Mix mix, uint64_t i) {
+        if (kBufferSize - position < kMaxRecordSize) {
+            position = 0;
+        }
+        const std::size_t before = position;
+        const int64_t v = value_for(i);
+        switch (mix) {
+            case Mix::Strings: text("%.*s", static_cast<int>(kUser.size()), kUser.data());
+                               text("%.*s", static_cast<int>(kMessage.size()), kMessage.data()); break;
+            case Mix::Dec: ints(v, IntFormat::Dec); break;
+            case Mix::Hex: ints(v, IntFormat::Hex); break;
+            case Mix::HEX: ints(v, IntFormat::HEX); break;
+            case Mix::Oct: ints(v, IntFormat::Oct); break;
+            case Mix::Blob: std::memcpy(storage.get() + position, kBlob, sizeof(kBlob)); position += sizeof(kBlob); break;
+            case Mix::Mixed:
+                text("%.*s", static_cast<int>(kUser.size()), kUser.data());
+                text("%.*s", static_cast<int>(kMessage.size()), kMessage.data());
+                ints(v, IntFormat::Dec);
+                ints(v, IntFormat::Hex);
+                std::memcpy(storage.get() + position, kBlob, sizeof(kBlob));
+                position += sizeof(kBlob);
+                break;
+        }
+        bench::do_not_optimize(storage[before]);
+        return position - before;
+    }
+};
+
+struct OstreamWriter {
+    std::ostringstream out;
+
+    inline void ints(int64_t v, IntFormat format) {
+        const uint32_t u = static_cast<uint32_t>(v);
+        const bool negative = v < 0;
+        const uint64_t magnitude = static_cast<uint64_t>(negative ? -v : v);
+        switch (format) {
+            case IntFormat::Dec: out << std::dec << v << '\0' << u << '\0'; break;
+            case IntFormat::Hex: out << (negative ? "-0x" : "0x") << std::hex << std::nouppercase << magnitude << '\0'
+                                     << "0x" << u << '\0'; break;
+            case IntFormat::HEX: out << (negative ? "-0X" : "0X") << std::hex << std::uppercase << magnitude << '\0'
+                                     << "0X" << u << '\0'; break;
+            case IntFormat::Oct: out << (negative ? "-0" : "0") << std::oct << magnitude << '\0'
+                                     << '0' << u << '\0'; break;
+        }
+    }
+
+    inline std::size_t record(Mix mix, uint64_t i) {
+        if (static_cast<std::size_t>(out.tellp()) > kBufferSize - kMaxRecordSize) {
+            out.str(std::string());
+        }
+        const std::size_t before = static_cast<std::size_t>(out.tellp());
+        const int64_t v = value_for(i);
+        switch (mix) {
+            case Mix::Strings: out << kUser << '\0' << kMessage << '\0'; break;
+            case Mix::Dec: ints(v, IntFormat::Dec); break;
+            case Mix::Hex: ints(v, IntFormat::Hex); break;
+            case Mix::HEX: ints(v, IntFormat::HEX); break;
+            case Mix::Oct: ints(v, IntFormat::Oct); break;
+            case Mix::Blob: out.write(reinterpret_cast<const char*>(kBlob), sizeof(kBlob)); break;
+            case Mix::Mixed:
+                out << kUser << '\0' << kMessage << '\0';
+                ints(v, IntFormat::Dec);
+                ints(v, IntFormat::Hex);
+                out.write(reinterpret_cast<const char*>(kBlob), sizeof(kBlob));
+                break;
+        }
+        return static_cast<std::size_t>(out.tellp()) - before;
+    }
+};
+
+struct ToCharsWriter {
+    std::unique_ptr<char[]> storage{new char[kBufferSize]};
+    std::size_t position = 0;
+
+    inline void text(std::string_view str) {
+        std::memcpy(storage.get() + position, str.data(), str.size());
+        position += str.size();
+        storage[position++] = '\0';
+    }
+
+    template<typename T>
+    inline void number(T v, std::string_view prefix, int base) {
+        char* out = storage.get() + position;
+        std::memcpy(out, prefix.data(), prefix.size());
+        out = std::to_chars(out + prefix.size(), storage.get() + kBufferSize, v, base).ptr;
+        *out++ = '\0';
+        position = static_cast<std::size_t>(out - storage.get());
+    }
+
+    inline void ints(int64_t v, IntFormat format) {
+        const uint32_t u = static_cast<uint32_t>(v);
+        switch (format) {
+            case IntFormat::Dec: number(v, "", 10); number(u, "", 10); break;
+            case IntFormat::Hex: number(v, "0x", 16); number(u, "0x", 16); break;
+            case IntFormat::HEX: {
+                const std::size_t start = position;
+                number(v, "0X", 16);
+                number(u, "0X", 16);
+                for (std::size_t p = start; p < position; ++p) {
+                    if (storage[p] >= 'a' && storage[p] <= 'f') {
+                        storage[p] = static_cast<char>(storage[p] - 'a' + 'A');
+                    }
+                }
+                break;
+            }
+            case IntFormat::Oct: number(v, "0", 8); number(u, "0", 8); break;
+        }
+    }
+
+    inline std::size_t record(Mix mix, uint64_t i) {
+        if (kBufferSize - position < kMaxRecordSize) {
+            position = 0;
+        }
+        const std::size_t before = position;
+        const int64_t v = value_for(i);
+        switch (mix) {
+            case Mix::Strings: text(kUser); text(kMessage); break;
+            case Mix::Dec: ints(v, IntFormat::Dec); break;
+            case Mix::Hex: ints(v, IntFormat::Hex); break;
+            case Mix::HEX: ints(v, IntFormat::HEX); break;
+            case Mix::Oct: ints(v, IntFormat::Oct); break;
+            case Mix::Blob: std::memcpy(storage.get() + position, kBlob, sizeof(kBlob)); position += sizeof(kBlob); break;
+            case Mix::Mixed:
+                text(kUser);
+                text(kMessage);
+                ints(v, IntFormat::Dec);
+                ints(v, IntFormat::Hex);
+                std::memcpy(storage.get() + position, kBlob, sizeof(kBlob));
+                position += sizeof(kBlob);
+                break;
+        }
+        bench::do_not_optimize(storage[before]);
+        return position - before;
+    }
+};
+
+template<typename Writer>
+void run(bench::Reporter& reporter, const char* name, Mix mix, uint64_t records) {
+    Writer writer;
+    for (uint64_t i = 0; i < records / 10; ++i) {
+        writer.record(mix, i); // warm up caches and the allocator
+    }
+    uint64_t bytes = 0;
+    const uint64_t start = bench::now_ns();
+    for (uint64_t i = 0; i < records; ++i) {
+        bytes += writer.record(mix, i);
+    }
+    const uint64_t elapsed = bench::now_ns() - start;
+    bench::do_not_optimize(bytes);
+
+    bench::Result result{std::string(name) + "/" + mix_name(mix), {}};
+    result.add("ns_per_record", static_cast<double>(elapsed) / static_cast<double>(records))
+          .add("bytes_per_record", static_cast<double>(bytes) / static_cast<double>(records));
+    reporter.add(result);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Reporter reporter("bench_baseline", argc, argv);
+    const uint64_t records = bench::option(argc, argv, "--records", 1000000);
+    for (Mix mix : kMixes) {
+        run<LoggerWriter>(reporter, "logger", mix, records);
+        run<SnprintfWriter>(reporter, "snprintf", mix, records);
+        run<OstreamWriter>(reporter, "ostringstream", mix, records);
+        run<ToCharsWriter>(reporter, "to_chars", mix, records);
+    }
+    return reporter.finish() ? 0 : 1;
+}
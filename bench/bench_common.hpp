@@ -0,0 +1,174 @@
+#pragma once
+
+// Shared helpers for the benchmark targets: timing, latency percentiles and
+// result reporting as a text table or JSON (--json <file>).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+/// Monotonic time in nanoseconds.
+inline uint64_t now_ns() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// Keep the compiler from discarding a computed value.
+template<typename T>
+inline void do_not_optimize(const T& value) noexcept {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// Compiler barrier around timed regions.
+inline void clobber_memory() noexcept {
+    asm volatile("" : : : "memory");
+}
+
+/**
+ * @brief Percentiles of a set of latency samples.
+ */
+struct LatencyStats {
+    double p50 = 0;   ///< Median, ns
+    double p99 = 0;   ///< 99th percentile, ns
+    double p999 = 0;  ///< 99.9th percentile, ns
+    double max = 0;   ///< Largest sample, ns
+};
+
+/**
+ * @brief Compute percentiles; reorders the samples.
+ *
+ * @param samples Latency samples in nanoseconds.
+ * @return The percentiles (all zero if there are no samples).
+ */
+inline LatencyStats latency_stats(std::vector<uint32_t>& samples) {
+    LatencyStats stats;
+    if (samples.empty()) {
+        return stats;
+    }
+    std::sort(samples.begin(), samples.end());
+    const auto at = [&](double q) {
+        const std::size_t index = static_cast<std::size_t>(q * static_cast<double>(samples.size() - 1));
+        return static_cast<double>(samples[index]);
+    };
+    stats.p50 = at(0.5);
+    stats.p99 = at(0.99);
+    stats.p999 = at(0.999);
+    stats.max = static_cast<double>(samples.back());
+    return stats;
+}
+
+/**
+ * @brief One benchmark result: a name plus named metrics.
+ */
+struct Result {
+    std::string name;                                    ///< e.g. "thread_local/4"
+    std::vector<std::pair<std::string, double>> metrics; ///< e.g. {"records_per_s", 1.2e8}
+
+    inline Result& add(const char* metric, double value) {
+        metrics.emplace_back(metric, value);
+        return *this;
+    }
+};
+
+/**
+ * @brief Collects results and prints them.
+ */
+class Reporter {
+public:
+    /**
+     * @brief Parse the common options.
+     *
+     * Recognizes --json <file> (write results as JSON) and leaves other
+     * arguments to the caller.
+     *
+     * @param suite Name of the benchmark target, stored in the JSON output.
+     * @param argc Argument count.
+     * @param argv Arguments.
+     */
+    inline Reporter(const char* suite, int argc, char** argv) : m_suite(suite) {
+        for (int i = 1; i + 1 < argc; ++i) {
+            if (std::strcmp(argv[i], "--json") == 0) {
+                m_json_path = argv[i + 1];
+            }
+        }
+    }
+
+    /// Record a result and print it as one table row.
+    inline void add(const Result& result) {
+        std::printf("%-32s", result.name.c_str());
+        for (const auto& metric : result.metrics) {
+            std::printf("  %s=%.6g", metric.first.c_str(), metric.second);
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+        m_results.push_back(result);
+    }
+
+    /**
+     * @brief Write the JSON file if --json was given.
+     *
+     * @return false if the file could not be written.
+     */
+    inline bool finish() const {
+        if (m_json_path.empty()) {
+            return true;
+        }
+        FILE* out = std::fopen(m_json_path.c_str(), "w");
+        if (out == nullptr) {
+            std::perror(m_json_path.c_str());
+            return false;
+        }
+        write_json(out);
+        return std::fclose(out) == 0;
+    }
+
+    /// Write all results as {"suite": ..., "results": [{"name": ..., "metrics": {...}}]}.
+    inline void write_json(FILE* out) const {
+        std::fprintf(out, "{\n  \"suite\": \"%s\",\n  \"results\": [\n", m_suite.c_str());
+        for (std::size_t i = 0; i < m_results.size(); ++i) {
+            std::fprintf(out, "    {\"name\": \"%s\", \"metrics\": {", m_results[i].name.c_str());
+            for (std::size_t j = 0; j < m_results[i].metrics.size(); ++j) {
+                std::fprintf(out, "%s\"%s\": %.9g", j == 0 ? "" : ", ",
+                             m_results[i].metrics[j].first.c_str(), m_results[i].metrics[j].second);
+            }
+            std::fprintf(out, "}}%s\n", i + 1 < m_results.size() ? "," : "");
+        }
+        std::fprintf(out, "  ]\n}\n");
+    }
+
+    /// Results recorded so far.
+    inline const std::vector<Result>& results() const noexcept { return m_results; }
+
+private:
+    std::string m_suite;            ///< Benchmark target name
+    std::string m_json_path;        ///< --json argument, or empty
+    std::vector<Result> m_results;  ///< Results in report order
+};
+
+/**
+ * @brief Read an unsigned option of the form "--name value".
+ *
+ * @param argc Argument count.
+ * @param argv Arguments.
+ * @param name Option name including dashes.
+ * @param fallback Value if the option is absent.
+ * @return The option value.
+ */
+inline uint64_t option(int argc, char** argv, const char* name, uint64_t fallback) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return std::strtoull(argv[i + 1], nullptr, 0);
+        }
+    }
+    return fallback;
+}
+
+} // namespace bench
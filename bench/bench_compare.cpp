@@ -0,0 +1,403 @@
+// Performance regression gate: run the Logger hot-path benchmarks several
+// times and compare them with a stored baseline.
+//
+//   bench_compare [--baseline file] [--repeats N] [--threshold PCT]
+//                 [--noise K] [--fail-new] [--update]
+//
+// Each suite is run --repeats times with --json. Every metric is reduced to
+// its median and median absolute deviation (MAD) over the runs. A metric
+// regresses when its median is worse than the baseline median by more than
+// --threshold percent AND by more than --noise times the combined MAD, so
+// one noisy run cannot fail the gate. Exit status is 1 on any regression.
+// Metrics missing from the baseline are listed as "new", and baseline
+// metrics the run no longer produces as "missing"; with --fail-new both fail
+// the gate too, so benchmarks cannot be added, renamed or dropped ungated.
+// --update rewrites the baseline from this machine's runs instead.
+//
+// The suites are looked up next to this executable.
+
+#include "bench_common.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+/// A benchmark target and the result rows that cover Logger hot paths.
+struct Suite {
+    const char* name;    ///< Executable name
+    const char* args;    ///< Extra arguments (smaller run sizes)
+    const char* prefix;  ///< Only rows whose name starts with this are kept
+};
+
+constexpr Suite kSuites[] = {
+    {"bench_kernels", "--calls 1000000", ""},
+    {"bench_baseline", "--records 500000", "logger/"},
+};
+
+/// Key of one metric: suite, result name, metric name.
+using Key = std::tuple<std::string, std::string, std::string>;
+
+/// Median and MAD of one metric.
+struct Summary {
+    double median = 0;
+    double mad = 0;
+};
+
+/**
+ * @brief Minimal reader for the JSON written by bench::Reporter and by --update.
+ *
+ * Supports objects, arrays, strings without escapes, and numbers, which is
+ * all either file contains.
+ */
+class JsonReader {
+public:
+    explicit JsonReader(std::string text) : m_text(std::move(text)) {}
+
+    bool ok() const noexcept { return m_ok; }
+
+    /// Consume `c` after whitespace; false (and not ok) if something else is there.
+    bool expect(char c) {
+        skip_space();
+        if (m_pos < m_text.size() && m_text[m_pos] == c) {
+            ++m_pos;
+            return true;
+        }
+        m_ok = false;
+        return false;
+    }
+
+    /// Consume `c` if it is next.
+    bool accept(char c) {
+        skip_space();
+        if (m_pos < m_text.size() && m_text[m_pos] == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    std::string string() {
+        std::string out;
+        if (!expect('"')) {
+            return out;
+        }
+        while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+            out += m_text[m_pos++];
+        }
+        expect('"');
+        return out;
+    }
+
+    double number() {
+        skip_space();
+        const char* begin = m_text.c_str() + m_pos;
+        char* end = nullptr;
+        const double value = std::strtod(begin, &end);
+        if (end == begin) {
+            m_ok = false;
+        }
+        m_pos += static_cast<std::size_t>(end - begin);
+        return value;
+    }
+
+    /**
+     * @brief Iterate the members of an object.
+     *
+     * Calls `member(key)` with the reader positioned at each value.
+     */
+    template<typename Member>
+    void object(Member member) {
+        if (!expect('{') || accept('}')) {
+            return;
+        }
+        do {
+            const std::string key = string();
+            if (!expect(':')) {
+                return;
+            }
+            member(key);
+        } while (m_ok && accept(','));
+        expect('}');
+    }
+
+    /// Iterate the elements of an array, calling `element()` at each.
+    template<typename Element>
+    void array(Element element) {
+        if (!expect('[') || accept(']')) {
+            return;
+        }
+        do {
+            element();
+        } while (m_ok && accept(','));
+        expect(']');
+    }
+
+private:
+    void skip_space() {
+        while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+            ++m_pos;
+        }
+    }
+
+    std::string m_text;     ///< Whole document
+    std::size_t m_pos = 0;  ///< Read position
+    bool m_ok = true;       ///< false after the first syntax error
+};
+
+bool read_file(const std::string& path, std::string& text) {
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+    char chunk[4096];
+    std::size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        text.append(chunk, n);
+    }
+    std::fclose(file);
+    return true;
+}
+
+/// Parse one Reporter JSON file, appending each kept metric's value.
+bool read_run(const std::string& path, const Suite& suite, std::map<Key, std::vector<double>>& values) {
+    std::string text;
+    if (!read_file(path, text)) {
+        return false;
+    }
+    JsonReader json(std::move(text));
+    json.object([&](const std::string& key) {
+        if (key == "suite") {
+            json.string();
+            return;
+        }
+        json.array([&] {
+            std::string name;
+            json.object([&](const std::string& field) {
+                if (field == "name") {
+                    name = json.string();
+                    return;
+                }
+                json.object([&](const std::string& metric) {
+                    const double value = json.number();
+                    if (name.compare(0, std::strlen(suite.prefix), suite.prefix) == 0) {
+                        values[Key(suite.name, name, metric)].push_back(value);
+                    }
+                });
+            });
+        });
+    });
+    return json.ok();
+}
+
+/// Parse a baseline file: {"suites": {suite: {result: {metric: {"median": m, "mad": d}}}}}.
+bool read_baseline(const std::string& path, std::map<Key, Summary>& baseline) {
+    std::string text;
+    if (!read_file(path, text)) {
+        return false;
+    }
+    JsonReader json(std::move(text));
+    json.object([&](const std::string&) {
+        json.object([&](const std::string& suite) {
+            json.object([&](const std::string& result) {
+                json.object([&](const std::string& metric) {
+                    Summary summary;
+                    json.object([&](const std::string& field) {
+                        (field == "median" ? summary.median : summary.mad) = json.number();
+                    });
+                    baseline[Key(suite, result, metric)] = summary;
+                });
+            });
+        });
+    });
+    return json.ok();
+}
+
+bool write_baseline(const std::string& path, const std::map<Key, Summary>& current) {
+    FILE* out = std::fopen(path.c_str(), "w");
+    if (out == nullptr) {
+        std::perror(path.c_str());
+        return false;
+    }
+    std::fprintf(out, "{\n  \"suites\": {");
+    const std::string* suite = nullptr;
+    const std::string* result = nullptr;
+    for (const auto& entry : current) {
+        const auto& [s, r, m] = entry.first;
+        if (suite == nullptr || *suite != s) {
+            std::fprintf(out, "%s\n    \"%s\": {\n      \"%s\": {", suite == nullptr ? "" : "}\n    },", s.c_str(), r.c_str());
+            suite = &s;
+            result = &r;
+        } else if (*result != r) {
+            std::fprintf(out, "},\n      \"%s\": {", r.c_str());
+            result = &r;
+        } else {
+            std::fprintf(out, ", ");
+        }
+        std::fprintf(out, "\"%s\": {\"median\": %.6g, \"mad\": %.3g}", m.c_str(), entry.second.median,
+                     entry.second.mad);
+    }
+    std::fprintf(out, "%s\n  }\n}\n", suite == nullptr ? "" : "}\n    }");
+    return std::fclose(out) == 0;
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const std::size_t n = values.size();
+    return n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+Summary summarize(const std::vector<double>& values) {
+    Summary summary;
+    summary.median = median(values);
+    std::vector<double> deviations;
+    for (double value : values) {
+        deviations.push_back(std::fabs(value - summary.median));
+    }
+    summary.mad = median(deviations);
+    return summary;
+}
+
+/// Throughput metrics improve upward; everything else (ns, bytes, events) downward.
+bool higher_is_better(const std::string& metric) {
+    return metric.size() >= 6 && metric.compare(metric.size() - 6, 6, "_per_s") == 0;
+}
+
+std::string string_option(int argc, char** argv, const char* name, const char* fallback) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+bool flag(int argc, char** argv, const char* name) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string baseline_path = string_option(argc, argv, "--baseline", "bench/baseline.json");
+    const uint64_t repeats = std::max<uint64_t>(1, bench::option(argc, argv, "--repeats", 5));
+    const double threshold = std::strtod(string_option(argc, argv, "--threshold", "10").c_str(), nullptr);
+    const double noise = std::strtod(string_option(argc, argv, "--noise", "3").c_str(), nullptr);
+    const bool update = flag(argc, argv, "--update");
+    const bool fail_new = flag(argc, argv, "--fail-new");
+
+    std::string dir = argv[0];
+    dir = dir.find('/') == std::string::npos ? "." : dir.substr(0, dir.rfind('/'));
+    const char* tmp = std::getenv("TMPDIR");
+    const std::string json_path = std::string(tmp != nullptr ? tmp : "/tmp") + "/bench_compare."
+                                + std::to_string(::getpid()) + ".json";
+
+    std::map<Key, std::vector<double>> values;
+    for (const Suite& suite : kSuites) {
+        for (uint64_t run = 0; run < repeats; ++run) {
+            std::fprintf(stderr, "running %s (%llu/%llu)\n", suite.name, static_cast<unsigned long long>(run + 1),
+                         static_cast<unsigned long long>(repeats));
+            const std::string command = "\"" + dir + "/" + suite.name + "\" " + suite.args + " --json \""
+                                      + json_path + "\" > /dev/null";
+            if (std::system(command.c_str()) != 0 || !read_run(json_path, suite, values)) {
+                std::fprintf(stderr, "bench_compare: %s failed\n", suite.name);
+                std::remove(json_path.c_str());
+                return 2;
+            }
+        }
+    }
+    std::remove(json_path.c_str());
+
+    std::map<Key, Summary> current;
+    for (const auto& entry : values) {
+        current[entry.first] = summarize(entry.second);
+    }
+    if (update) {
+        if (!write_baseline(baseline_path, current)) {
+            return 2;
+        }
+        std::printf("wrote %zu metrics to %s\n", current.size(), baseline_path.c_str());
+        return 0;
+    }
+
+    std::map<Key, Summary> baseline;
+    if (!read_baseline(baseline_path, baseline)) {
+        std::fprintf(stderr, "bench_compare: cannot read baseline %s (create it with --update)\n",
+                     baseline_path.c_str());
+        return 2;
+    }
+
+    std::printf("%-16s %-34s %-14s %12s %12s %8s  %s\n", "suite", "result", "metric", "baseline", "current",
+                "change", "status");
+    int regressions = 0;
+    int missing = 0;
+    for (const auto& entry : baseline) {
+        const auto& [suite, result, metric] = entry.first;
+        const auto found = current.find(entry.first);
+        if (found == current.end()) {
+            std::printf("%-16s %-34s %-14s %12.4g %12s %8s  missing\n", suite.c_str(), result.c_str(),
+                        metric.c_str(), entry.second.median, "-", "-");
+            ++missing;
+            continue;
+        }
+        const Summary& base = entry.second;
+        const Summary& now = found->second;
+        if (base.median == 0) {
+            continue; // nothing to scale against (e.g. an event that never fires)
+        }
+        const double change = (now.median - base.median) / base.median * 100;
+        const double worse = higher_is_better(metric) ? -change : change;
+        // 1.4826 * MAD estimates the standard deviation of normally distributed noise.
+        const double spread = 1.4826 * std::sqrt(base.mad * base.mad + now.mad * now.mad);
+        const bool significant = std::fabs(now.median - base.median) > noise * spread;
+        const char* status = "ok";
+        if (worse > threshold && significant) {
+            status = "REGRESSED";
+            ++regressions;
+        } else if (worse > threshold) {
+            status = "noisy";
+        } else if (worse < -threshold && significant) {
+            status = "improved";
+        }
+        std::printf("%-16s %-34s %-14s %12.4g %12.4g %+7.1f%%  %s\n", suite.c_str(), result.c_str(), metric.c_str(),
+                    base.median, now.median, change, status);
+    }
+    int added = 0;
+    for (const auto& entry : current) {
+        if (baseline.count(entry.first) != 0) {
+            continue;
+        }
+        const auto& [suite, result, metric] = entry.first;
+        std::printf("%-16s %-34s %-14s %12s %12.4g %8s  new\n", suite.c_str(), result.c_str(), metric.c_str(), "-",
+                    entry.second.median, "-");
+        ++added;
+    }
+
+    if (added > 0) {
+        std::printf("\n%d metric(s) not in the baseline; re-record it with --update\n", added);
+    }
+    if (missing > 0) {
+        std::printf("\n%d baseline metric(s) not produced by this run; re-record it with --update\n", missing);
+    }
+    if (regressions > 0) {
+        std::printf("\n%d metric(s) regressed by more than %.1f%% (median of %llu runs, beyond %.1fx MAD)\n",
+                    regressions, threshold, static_cast<unsigned long long>(repeats), noise);
+        return 1;
+    }
+    if (fail_new && (added > 0 || missing > 0)) {
+        return 1;
+    }
+    std::printf("\nno regressions beyond %.1f%%\n", threshold);
+    return 0;
+}
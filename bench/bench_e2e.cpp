@@ -0,0 +1,304 @@
+// End-to-end pipeline: producers -> BufferPool -> Drainer -> file -> decoder.
+//
+//   bench_e2e [--producers N] [--millis N] [--rate N] [--buffers N]
+//             [--buffer-size N] [--max-format-threads N] [--path file] [--json file]
+//
+// Producers write framed records (producer id as tag, sequence number and
+// produce timestamp as fields) into pooled buffers. A Drainer writes every
+// sealed buffer to a file (tmpfs by default) and notes when each write
+// completed. The file is then mapped and decoded, and every record is
+// matched to the write that made it durable. Two phases are run:
+//   sustained  each producer paced at --rate records/s
+//   overload   producers unthrottled; when no buffer is free the record is
+//              dropped rather than blocking the producer
+// and for each the suite reports delivered records/s, produce-to-file
+// latency percentiles, loss, and decode throughput. Records that were
+// neither delivered nor counted as dropped fail the run.
+//
+// A third phase, text/<threads>, drains through a FormatDrainer with 1, 2,
+// 4 ... --max-format-threads formatter threads writing format_text() output,
+// with producers waiting for buffers instead of dropping, and reports how
+// text throughput scales with formatter threads.
+
+#include "bench_common.hpp"
+
+#include "log_buffer/decoder.hpp"
+#include "log_buffer/drain.hpp"
+#include "log_buffer/logger.hpp"
+
+#include <atomic>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace log_buffer;
+
+namespace {
+
+/// Where one drained buffer ended up in the file.
+struct Write {
+    uint64_t end_offset;  ///< File offset just past the buffer
+    uint64_t done_ns;     ///< When write() returned
+};
+
+/// Per-producer counters.
+struct ProducerStats {
+    uint64_t produced = 0;  ///< Records attempted
+    uint64_t dropped = 0;   ///< Records dropped for lack of a free buffer
+};
+
+struct Options {
+    unsigned producers;
+    uint64_t millis;
+    uint64_t rate;
+    std::size_t buffers;
+    std::size_t buffer_size;
+    std::string path;
+};
+
+inline bool write_record(Logger& logger, uint16_t producer, uint64_t sequence, uint64_t timestamp) noexcept {
+    logger.begin_record(Level::Info, producer);
+    logger << sequence << timestamp;
+    return logger.end_record();
+}
+
+/// Produce until `deadline`, pacing to `rate` records/s if nonzero. Never blocks on the pool.
+void produce(BufferPool& pool, uint16_t producer, uint64_t start, uint64_t deadline, uint64_t rate,
+             ProducerStats& stats) {
+    Logger logger(nullptr, 0);
+    logger.set_buffer_header(true);
+    const double period = rate != 0 ? 1e9 / static_cast<double>(rate) : 0;
+    for (uint64_t sequence = 0;; ++sequence) {
+        uint64_t now = bench::now_ns();
+        if (rate != 0) {
+            const uint64_t due = start + static_cast<uint64_t>(period * static_cast<double>(sequence));
+            while (now < due) {
+                std::this_thread::yield();
+                now = bench::now_ns();
+            }
+        }
+        if (now >= deadline) {
+            break;
+        }
+        ++stats.produced;
+        if (logger.data() == nullptr && !pool.acquire(logger)) {
+            ++stats.dropped;
+            continue;
+        }
+        if (!write_record(logger, producer, sequence, now)) {
+            pool.seal(logger);
+            if (!pool.acquire(logger) || !write_record(logger, producer, sequence, now)) {
+                ++stats.dropped;
+            }
+        }
+    }
+    pool.seal(logger);
+}
+
+/// Run one phase and report it; false if records went missing without being counted.
+bool run(bench::Reporter& reporter, const char* phase, const Options& options, uint64_t rate) {
+    const int fd = ::open(options.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::perror(options.path.c_str());
+        return false;
+    }
+    std::vector<Write> writes;
+    writes.reserve(1 << 16);
+    uint64_t file_size = 0;
+    bool write_failed = false;
+
+    BufferPool pool(options.buffers, options.buffer_size);
+    Drainer drainer(pool, [&](const uint8_t* data, std::size_t size) {
+        if (::write(fd, data, size) != static_cast<ssize_t>(size)) {
+            write_failed = true;
+        }
+        file_size += size;
+        writes.push_back(Write{file_size, bench::now_ns()});
+    });
+    drainer.start();
+
+    std::vector<ProducerStats> stats(options.producers);
+    std::vector<std::thread> producers;
+    const uint64_t start = bench::now_ns() + 1000000; // let every thread reach the start line
+    const uint64_t deadline = start + options.millis * 1000000;
+    for (unsigned p = 0; p < options.producers; ++p) {
+        producers.emplace_back([&, p] {
+            while (bench::now_ns() < start) {
+                std::this_thread::yield();
+            }
+            produce(pool, static_cast<uint16_t>(p), start, deadline, rate, stats[p]);
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    drainer.stop();
+    const uint64_t end = bench::now_ns();
+    ::close(fd);
+    if (write_failed) {
+        std::fprintf(stderr, "bench_e2e: short write to %s\n", options.path.c_str());
+        return false;
+    }
+
+    // Read the file back and match each record to the write that made it durable
+    MappedDump dump;
+    if (!dump.open(options.path.c_str())) {
+        std::fprintf(stderr, "bench_e2e: cannot map %s\n", options.path.c_str());
+        return false;
+    }
+    std::vector<uint64_t> delivered(options.producers, 0);
+    std::vector<uint32_t> latencies;
+    const uint64_t decode_start = bench::now_ns();
+    RecordReader reader(dump.data(), dump.size());
+    RecordView record;
+    std::size_t write_index = 0;
+    uint64_t malformed_fields = 0;
+    while (reader.next(record)) {
+        const uint64_t offset = static_cast<uint64_t>(record.data - dump.data());
+        while (write_index + 1 < writes.size() && offset >= writes[write_index].end_offset) {
+            ++write_index;
+        }
+        FieldReader fields(record);
+        uint64_t sequence = 0;
+        uint64_t timestamp = 0;
+        if (record.tag >= options.producers || !fields.read_int(sequence) || !fields.read_int(timestamp)) {
+            ++malformed_fields;
+            continue;
+        }
+        ++delivered[record.tag];
+        const uint64_t latency = writes[write_index].done_ns - timestamp;
+        latencies.push_back(latency > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(latency));
+    }
+    const uint64_t decode_ns = bench::now_ns() - decode_start;
+    unlink(options.path.c_str());
+
+    uint64_t produced = 0;
+    uint64_t dropped = 0;
+    uint64_t received = 0;
+    for (unsigned p = 0; p < options.producers; ++p) {
+        produced += stats[p].produced;
+        dropped += stats[p].dropped;
+        received += delivered[p];
+    }
+    const uint64_t decoded = latencies.size();
+    const bench::LatencyStats latency = bench::latency_stats(latencies);
+    const double seconds = static_cast<double>(end - start) * 1e-9;
+
+    bench::Result result{std::string(phase) + "/" + std::to_string(options.producers), {}};
+    result.add("records_per_s", static_cast<double>(received) / seconds)
+          .add("mb_per_s", static_cast<double>(file_size) / seconds / 1e6)
+          .add("loss_pct", produced != 0 ? 100.0 * static_cast<double>(dropped) / static_cast<double>(produced) : 0)
+          .add("e2e_ns_p50", latency.p50)
+          .add("e2e_ns_p99", latency.p99)
+          .add("e2e_ns_p999", latency.p999)
+          .add("e2e_ns_max", latency.max)
+          .add("decode_records_per_s", decode_ns != 0 ? static_cast<double>(decoded) * 1e9 / static_cast<double>(decode_ns) : 0);
+    reporter.add(result);
+
+    if (received + dropped != produced || malformed_fields != 0 || reader.malformed()) {
+        std::fprintf(stderr, "bench_e2e: %s: produced %llu, delivered %llu, dropped %llu, malformed %llu\n", phase,
+                     static_cast<unsigned long long>(produced), static_cast<unsigned long long>(received),
+                     static_cast<unsigned long long>(dropped), static_cast<unsigned long long>(malformed_fields));
+        return false;
+    }
+    return true;
+}
+
+/// Run producers flat out into a FormatDrainer and report text throughput.
+bool run_text(bench::Reporter& reporter, const Options& options, std::size_t threads) {
+    const int fd = ::open(options.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::perror(options.path.c_str());
+        return false;
+    }
+    uint64_t text_bytes = 0;
+    bool write_failed = false;
+    BufferPool pool(options.buffers, options.buffer_size);
+    FormatDrainer drainer(pool, threads,
+        [](const uint8_t* data, std::size_t size, std::string& out) { format_text(data, size, out); },
+        [&](const char* text, std::size_t size) {
+            write_failed |= ::write(fd, text, size) != static_cast<ssize_t>(size);
+            text_bytes += size;
+        });
+    drainer.start();
+
+    std::vector<uint64_t> produced(options.producers, 0);
+    std::vector<std::thread> producers;
+    const uint64_t start = bench::now_ns();
+    const uint64_t deadline = start + options.millis * 1000000;
+    for (unsigned p = 0; p < options.producers; ++p) {
+        producers.emplace_back([&, p] {
+            Logger logger(nullptr, 0);
+            const auto acquire = [&] {
+                while (!pool.acquire(logger)) {
+                    std::this_thread::yield(); // backpressure instead of loss
+                }
+            };
+            acquire();
+            for (uint64_t sequence = 0;; ++sequence) {
+                const uint64_t now = bench::now_ns();
+                if (now >= deadline) {
+                    break;
+                }
+                if (!write_record(logger, static_cast<uint16_t>(p), sequence, now)) {
+                    pool.seal(logger);
+                    acquire();
+                    write_record(logger, static_cast<uint16_t>(p), sequence, now);
+                }
+                ++produced[p];
+            }
+            pool.seal(logger);
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    drainer.stop();
+    const double seconds = static_cast<double>(bench::now_ns() - start) * 1e-9;
+    ::close(fd);
+    unlink(options.path.c_str());
+
+    uint64_t records = 0;
+    for (uint64_t count : produced) {
+        records += count;
+    }
+    bench::Result result{"text/" + std::to_string(threads), {}};
+    result.add("records_per_s", static_cast<double>(records) / seconds)
+          .add("text_mb_per_s", static_cast<double>(text_bytes) / seconds / 1e6);
+    reporter.add(result);
+    return !write_failed;
+}
+
+std::string default_path() {
+    const char* dir = access("/dev/shm", W_OK) == 0 ? "/dev/shm" : std::getenv("TMPDIR");
+    return std::string(dir != nullptr ? dir : "/tmp") + "/bench_e2e." + std::to_string(::getpid()) + ".log";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Reporter reporter("bench_e2e", argc, argv);
+    Options options;
+    options.producers = static_cast<unsigned>(bench::option(argc, argv, "--producers", 2));
+    options.millis = bench::option(argc, argv, "--millis", 1000);
+    options.rate = bench::option(argc, argv, "--rate", 200000);
+    options.buffers = static_cast<std::size_t>(bench::option(argc, argv, "--buffers", 8));
+    options.buffer_size = static_cast<std::size_t>(bench::option(argc, argv, "--buffer-size", 64 * 1024));
+    options.path = default_path();
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--path") == 0) {
+            options.path = argv[i + 1];
+        }
+    }
+
+    bool ok = run(reporter, "sustained", options, options.rate);
+    ok = run(reporter, "overload", options, 0) && ok;
+    const unsigned hardware = std::thread::hardware_concurrency();
+    const uint64_t max_threads = bench::option(argc, argv, "--max-format-threads", hardware > 1 ? hardware : 4);
+    for (uint64_t threads = 1; threads <= max_threads; threads *= 2) {
+        ok = run_text(reporter, options, static_cast<std::size_t>(threads)) && ok;
+    }
+    return reporter.finish() && ok ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+// Hardware counters per call for each Logger::log() overload and IntFormat.
+//
+//   bench_kernels [--calls N] [--json file]
+//
+// Reports ns, instructions, cycles, branch misses and L1D/LLC misses per
+// call, so a slow path can be traced to its cause (e.g. the IntFormat
+// switch or the uppercase pass for IntFormat::HEX). Where perf_event_open
+// is not permitted only ns_per_call is reported.
+
+#include "bench_common.hpp"
+#include "perf_counters.hpp"
+
+#include "log_buffer/governor.hpp"
+#include "log_buffer/logger.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+using namespace log_buffer;
+
+namespace {
+
+constexpr std::size_t kBufferSize = 64 * 1024;
+constexpr std::size_t kMaxCallSize = 256;
+
+/// Logger over a private buffer that rewinds before it can overflow.
+struct Target {
+    std::unique_ptr<uint8_t[]> storage{new uint8_t[kBufferSize]};
+    Logger logger{storage.get(), kBufferSize};
+
+    inline Logger& get() noexcept {
+        if (logger.remaining_capacity() < kMaxCallSize) {
+            logger.reset();
+        }
+        return logger;
+    }
+};
+
+template<typename Kernel>
+void run(bench::Reporter& reporter, bench::PerfCounters& counters, const char* name, uint64_t calls,
+         Kernel kernel) {
+    for (uint64_t i = 0; i < calls / 10; ++i) {
+        kernel(i); // warm up
+    }
+    bench::Result result{name, {}};
+    bench::measure_per_call(counters, calls, kernel).add_to(result);
+    reporter.add(result);
+}
+
+inline uint64_t value_for(uint64_t i) noexcept {
+    return i * 2654435761u;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Reporter reporter("bench_kernels", argc, argv);
+    const uint64_t calls = bench::option(argc, argv, "--calls", 2000000);
+    bench::PerfCounters counters;
+    const std::string perf_status = counters.unavailable();
+    if (!perf_status.empty()) {
+        std::printf("# %s\n", perf_status.c_str());
+    }
+
+    Target target;
+    const uint8_t blob[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    const std::string text = "login accepted from gateway";
+    const std::u16string text16 = u"login accepted from gateway";
+    const std::u16string text16_wide = u"Grüße aus Köln";
+    const std::u32string text32 = U"login accepted from gateway";
+
+    run(reporter, counters, "log(bytes,16)", calls, [&](uint64_t) { target.get().log(blob, sizeof(blob)); });
+    run(reporter, counters, "log(string_view)", calls, [&](uint64_t) { target.get().log(std::string_view(text)); });
+    run(reporter, counters, "log(const char*)", calls, [&](uint64_t) { target.get().log(text.c_str()); });
+    run(reporter, counters, "log(std::string)", calls, [&](uint64_t) { target.get().log(text); });
+    run(reporter, counters, "log(string_view,max=8)", calls, [&](uint64_t) {
+        target.get().log(std::string_view(text), 8);
+    });
+    run(reporter, counters, "log(u16string_view)/ascii", calls, [&](uint64_t) {
+        target.get().log(std::u16string_view(text16));
+    });
+    run(reporter, counters, "log(u16string_view)/non_ascii", calls, [&](uint64_t) {
+        target.get().log(std::u16string_view(text16_wide));
+    });
+    run(reporter, counters, "log(u32string_view)", calls, [&](uint64_t) {
+        target.get().log(std::u32string_view(text32));
+    });
+
+    constexpr IntFormat kFormats[] = {IntFormat::Dec, IntFormat::Hex, IntFormat::HEX, IntFormat::Oct};
+    constexpr const char* kFormatNames[] = {"dec", "hex", "HEX", "oct"};
+    for (int f = 0; f < 4; ++f) {
+        target.logger.set_int_format(kFormats[f]);
+        run(reporter, counters, (std::string("log(uint32)/") + kFormatNames[f]).c_str(), calls, [&](uint64_t i) {
+            target.get().log(static_cast<uint32_t>(value_for(i)));
+        });
+        run(reporter, counters, (std::string("log(int64)/") + kFormatNames[f]).c_str(), calls, [&](uint64_t i) {
+            target.get().log(static_cast<int64_t>(value_for(i)) - (int64_t{1} << 40));
+        });
+    }
+    target.logger.set_int_format(IntFormat::Dec);
+
+    target.logger.set_string_format(StringFormat::LengthPrefixed);
+    run(reporter, counters, "log(string_view)/prefixed", calls, [&](uint64_t) {
+        target.get().log(std::string_view(text));
+    });
+    run(reporter, counters, "log(uint32)/prefixed", calls, [&](uint64_t i) {
+        target.get().log(static_cast<uint32_t>(value_for(i)));
+    });
+    target.logger.set_string_format(StringFormat::NulTerminated);
+
+    run(reporter, counters, "begin_record+end_record", calls, [&](uint64_t) {
+        Logger& logger = target.get();
+        logger.begin_record(Level::Info, 1);
+        logger.end_record();
+    });
+    target.logger.set_sequence_numbers(true).set_record_metadata(true);
+    run(reporter, counters, "begin_record+end_record/seq+meta", calls, [&](uint64_t) {
+        Logger& logger = target.get();
+        logger.begin_record(Level::Info, 1, 42);
+        logger.end_record();
+    });
+
+    Governor governor;
+    run(reporter, counters, "governor admit+Scope", calls, [&](uint64_t) {
+        if (governor.admit(Level::Info)) {
+            Governor::Scope timed(governor);
+            bench::clobber_memory();
+        }
+    });
+    const std::string perf_after = counters.unavailable();
+    if (perf_after != perf_status) {
+        std::printf("# %s\n", perf_after.c_str());  // events the PMU never scheduled are left out
+    }
+    return reporter.finish() ? 0 : 1;
+}
@@ -0,0 +1,325 @@
+// Multi-threaded scalability of the ways producers can share logging.
+//
+//   bench_scaling [--max-threads N] [--records N] [--json file]
+//
+// For 1, 2, 4 ... max-threads producers, each writing --records framed
+// records, measures:
+//   thread_local  one Logger and buffer per thread, reset when full
+//   mutex_shared  one Logger behind a std::mutex (the baseline)
+//   child         per-thread children carved from a shared parent
+//   pool_drainer  BufferPool buffers sealed to a background Drainer
+//   pool_format   the same, drained through a FormatDrainer (2 formatters)
+//   pool_async    coroutine producers waiting on an AsyncPool (C++20 builds)
+// and reports throughput, sampled per-call latency and, where
+// perf_event_open is permitted, cache misses per record.
+
+#include "bench_common.hpp"
+#include "perf_counters.hpp"
+
+#include "log_buffer/async.hpp"
+#include "log_buffer/decoder.hpp"
+#include "log_buffer/drain.hpp"
+#include "log_buffer/logger.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace log_buffer;
+
+namespace {
+
+constexpr std::size_t kBufferSize = 64 * 1024;
+constexpr std::size_t kChildSize = 4 * 1024;
+constexpr uint32_t kSampleEvery = 32;  // time one call in this many
+
+/// Per-thread measurements, merged after the run.
+struct ThreadStats {
+    std::vector<uint32_t> latencies;
+    bench::PerfSample perf;
+};
+
+/// Write one typical record; false if it did not fit.
+inline bool write_record(Logger& logger, uint64_t i) noexcept {
+    logger.begin_record(Level::Info, 7);
+    logger << "request" << i << "status" << 200;
+    return logger.end_record();
+}
+
+/**
+ * Run `body(thread_index, stats)` on `threads` threads and report the result.
+ * Each body writes `records` records and samples latencies itself.
+ */
+template<typename Body>
+void run(bench::Reporter& reporter, const char* variant, unsigned threads, uint64_t records, Body body) {
+    std::vector<ThreadStats> stats(threads);
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false};
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            bench::PerfCounters counters;
+            stats[t].latencies.reserve(records / kSampleEvery + 1);
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            counters.start();
+            body(t, stats[t]);
+            stats[t].perf = counters.stop();
+        });
+    }
+    while (ready.load() != threads) {
+        std::this_thread::yield();
+    }
+    const uint64_t start = bench::now_ns();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const double seconds = static_cast<double>(bench::now_ns() - start) * 1e-9;
+
+    std::vector<uint32_t> latencies;
+    bench::PerfSample perf;
+    for (auto& s : stats) {
+        latencies.insert(latencies.end(), s.latencies.begin(), s.latencies.end());
+        perf += s.perf;
+    }
+    const double total = static_cast<double>(records) * threads;
+    const bench::LatencyStats latency = bench::latency_stats(latencies);
+
+    bench::Result result{std::string(variant) + "/" + std::to_string(threads), {}};
+    result.add("records_per_s", total / seconds)
+          .add("ns_p50", latency.p50)
+          .add("ns_p99", latency.p99)
+          .add("ns_p999", latency.p999);
+    if (perf.has(bench::PerfEvent::LlcMisses)) {
+        result.add("llc_misses_per_record", static_cast<double>(perf[bench::PerfEvent::LlcMisses]) / total);
+    }
+    if (perf.has(bench::PerfEvent::L1dMisses)) {
+        result.add("l1d_misses_per_record", static_cast<double>(perf[bench::PerfEvent::L1dMisses]) / total);
+    }
+    reporter.add(result);
+}
+
+/// Time every kSampleEvery-th call of `write`, which returns false when the buffer is full.
+template<typename Write, typename Rotate>
+inline void produce(uint64_t records, ThreadStats& stats, Write write, Rotate rotate) {
+    for (uint64_t i = 0; i < records; ++i) {
+        if (i % kSampleEvery == 0) {
+            const uint64_t begin = bench::now_ns();
+            if (!write(i)) {
+                rotate();
+                write(i);
+            }
+            stats.latencies.push_back(static_cast<uint32_t>(bench::now_ns() - begin));
+        } else if (!write(i)) {
+            rotate();
+            write(i);
+        }
+    }
+}
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+#define BENCH_HAVE_ASYNC 1
+
+/// Producer coroutine, started and resumed by its own thread.
+struct Task {
+    struct promise_type {
+        Task get_return_object() noexcept { return Task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+
+/// Where the drainer hands a resumption back to the producer thread that owns the coroutine.
+struct Inbox {
+    std::atomic<void*> frame{nullptr};  ///< Address of the thread's coroutine
+    std::atomic<bool> ready{false};     ///< Set by the scheduler, cleared by the thread
+};
+
+struct Inboxes {
+    std::unique_ptr<Inbox[]> inbox;
+    unsigned count;
+};
+
+/// AsyncPool scheduler: flag the owning thread instead of resuming on the drainer.
+void schedule(std::coroutine_handle<> handle, void* context) {
+    auto* inboxes = static_cast<Inboxes*>(context);
+    for (unsigned t = 0; t < inboxes->count; ++t) {
+        if (inboxes->inbox[t].frame.load(std::memory_order_relaxed) == handle.address()) {
+            inboxes->inbox[t].ready.store(true, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+/// Like produce(), but a full buffer is sealed and the next one awaited.
+Task produce_async(BufferPool& pool, AsyncLogger& log, uint64_t records, ThreadStats& stats) {
+    co_await log.acquire();
+    for (uint64_t i = 0; i < records; ++i) {
+        const bool sampled = i % kSampleEvery == 0;
+        const uint64_t begin = sampled ? bench::now_ns() : 0;
+        if (!write_record(log.logger(), i)) {
+            pool.seal(log.logger());
+            co_await log.acquire();  // suspends only while every buffer is in flight
+            write_record(log.logger(), i);
+        }
+        if (sampled) {
+            stats.latencies.push_back(static_cast<uint32_t>(bench::now_ns() - begin));
+        }
+    }
+    pool.seal(log.logger());
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Reporter reporter("bench_scaling", argc, argv);
+    const unsigned hardware = std::thread::hardware_concurrency();
+    const unsigned max_threads = static_cast<unsigned>(bench::option(argc, argv, "--max-threads", hardware > 1 ? hardware : 4));
+    const uint64_t records = bench::option(argc, argv, "--records", 1000000);
+
+    const std::string perf_status = bench::PerfCounters().unavailable();
+    if (!perf_status.empty()) {
+        std::printf("# %s\n", perf_status.c_str());
+    }
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        run(reporter, "thread_local", threads, records, [&](unsigned, ThreadStats& stats) {
+            std::unique_ptr<uint8_t[]> buffer(new uint8_t[kBufferSize]);
+            Logger logger(buffer.get(), kBufferSize);
+            produce(records, stats, [&](uint64_t i) { return write_record(logger, i); },
+                    [&] { logger.reset(); });
+        });
+
+        std::unique_ptr<uint8_t[]> shared_buffer(new uint8_t[kBufferSize]);
+        Logger shared(shared_buffer.get(), kBufferSize);
+        std::mutex shared_mutex;
+        run(reporter, "mutex_shared", threads, records, [&](unsigned, ThreadStats& stats) {
+            produce(records, stats,
+                    [&](uint64_t i) {
+                        std::lock_guard<std::mutex> lock(shared_mutex);
+                        if (!write_record(shared, i)) {
+                            shared.reset();
+                            write_record(shared, i);
+                        }
+                        return true;
+                    },
+                    [] {});
+        });
+
+        std::unique_ptr<uint8_t[]> parent_buffer(new uint8_t[kBufferSize * threads]);
+        Logger parent(parent_buffer.get(), kBufferSize * threads);
+        std::mutex parent_mutex;
+        unsigned outstanding = 0;
+        run(reporter, "child", threads, records, [&](unsigned, ThreadStats& stats) {
+            Logger child(nullptr, 0);
+            const auto rotate = [&] {
+                std::unique_lock<std::mutex> lock(parent_mutex);
+                if (child.data() != nullptr) {
+                    child.close();
+                    --outstanding;
+                }
+                for (;;) {
+                    child = parent.child(kChildSize);
+                    if (child.data() != nullptr) {
+                        ++outstanding;
+                        return;
+                    }
+                    if (outstanding == 0) {
+                        parent.reset(); // every section is closed: start over
+                    } else {
+                        lock.unlock();
+                        std::this_thread::yield();
+                        lock.lock();
+                    }
+                }
+            };
+            rotate();
+            produce(records, stats, [&](uint64_t i) { return write_record(child, i); }, rotate);
+            std::lock_guard<std::mutex> lock(parent_mutex);
+            child.close();
+            --outstanding;
+        });
+
+        BufferPool pool(4 * threads, kBufferSize);
+        Drainer drainer(pool, [](const uint8_t* data, std::size_t size) {
+            bench::do_not_optimize(data[size - 1]);
+        });
+        drainer.start();
+        run(reporter, "pool_drainer", threads, records, [&](unsigned, ThreadStats& stats) {
+            Logger logger(nullptr, 0);
+            const auto rotate = [&] {
+                pool.seal(logger);
+                while (!pool.acquire(logger)) {
+                    std::this_thread::yield(); // backpressure: all buffers in flight
+                }
+            };
+            while (!pool.acquire(logger)) {
+                std::this_thread::yield();
+            }
+            produce(records, stats, [&](uint64_t i) { return write_record(logger, i); }, rotate);
+            pool.seal(logger);
+        });
+        drainer.stop();
+
+        BufferPool format_pool(4 * threads, kBufferSize);
+        FormatDrainer format_drainer(format_pool, 2,
+                                     [](const uint8_t* data, std::size_t size, std::string& out) {
+                                         format_text(data, size, out);
+                                     },
+                                     [](const char* text, std::size_t size) {
+                                         bench::do_not_optimize(text[size - 1]);
+                                     });
+        format_drainer.start();
+        run(reporter, "pool_format", threads, records, [&](unsigned, ThreadStats& stats) {
+            Logger logger(nullptr, 0);
+            const auto rotate = [&] {
+                format_pool.seal(logger);
+                while (!format_pool.acquire(logger)) {
+                    std::this_thread::yield();
+                }
+            };
+            while (!format_pool.acquire(logger)) {
+                std::this_thread::yield();
+            }
+            produce(records, stats, [&](uint64_t i) { return write_record(logger, i); }, rotate);
+            format_pool.seal(logger);
+        });
+        format_drainer.stop();
+
+#ifdef BENCH_HAVE_ASYNC
+        BufferPool async_pool(4 * threads, kBufferSize);
+        Inboxes inboxes{std::unique_ptr<Inbox[]>(new Inbox[threads]), threads};
+        AsyncPool async(async_pool, schedule, &inboxes);
+        Drainer async_drainer(async_pool, [](const uint8_t* data, std::size_t size) {
+            bench::do_not_optimize(data[size - 1]);
+        });
+        async_drainer.start();
+        run(reporter, "pool_async", threads, records, [&](unsigned t, ThreadStats& stats) {
+            AsyncLogger log(async);
+            Task task = produce_async(async_pool, log, records, stats);
+            Inbox& inbox = inboxes.inbox[t];
+            inbox.frame.store(task.handle.address(), std::memory_order_relaxed);
+            task.handle.resume();
+            while (!task.handle.done()) {
+                while (!inbox.ready.exchange(false, std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                task.handle.resume();
+            }
+            task.handle.destroy();
+        });
+        async_drainer.stop();
+#endif
+    }
+    return reporter.finish() ? 0 : 1;
+}
@@ -0,0 +1,300 @@
+#pragma once
+
+// Minimal perf_event_open wrapper for the benchmark targets. Counters are
+// per thread: open them on the thread being measured. If the kernel refuses
+// (perf_event_paranoid, containers, non-Linux), the wrapper degrades to
+// timing-only mode: available() is false, unavailable() explains why, and
+// the counters read as zero so benchmarks still report their timings.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "bench_common.hpp"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define BENCH_HAVE_PERF_EVENTS 1
+#endif
+
+namespace bench {
+
+/**
+ * @brief Hardware events that PerfCounters can count.
+ */
+enum class PerfEvent {
+    LlcMisses,     ///< Last-level cache misses
+    L1dMisses,     ///< L1 data cache read misses
+    Instructions,  ///< Retired instructions
+    Cycles,        ///< CPU cycles
+    BranchMisses,  ///< Mispredicted branches
+};
+
+inline constexpr int kPerfEventCount = 5;
+
+/// Short name of an event, used as a metric name.
+inline const char* perf_event_name(PerfEvent event) noexcept {
+    switch (event) {
+        case PerfEvent::LlcMisses: return "llc_misses";
+        case PerfEvent::L1dMisses: return "l1d_misses";
+        case PerfEvent::Instructions: return "instructions";
+        case PerfEvent::Cycles: return "cycles";
+        case PerfEvent::BranchMisses: return "branch_misses";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Counter values read by PerfCounters::stop().
+ */
+struct PerfSample {
+    uint64_t values[kPerfEventCount] = {};  ///< Indexed by PerfEvent
+    bool counted[kPerfEventCount] = {};     ///< Whether values[i] was measured (the event ran)
+    uint32_t samples = 0;                   ///< Number of stop() results summed into this one
+
+    inline uint64_t operator[](PerfEvent event) const noexcept { return values[static_cast<int>(event)]; }
+
+    /// Whether an event was measured in every summed sample.
+    inline bool has(PerfEvent event) const noexcept { return counted[static_cast<int>(event)]; }
+
+    inline PerfSample& operator+=(const PerfSample& other) noexcept {
+        for (int i = 0; i < kPerfEventCount; ++i) {
+            values[i] += other.values[i];
+            counted[i] = (samples == 0 || counted[i]) && other.counted[i];
+        }
+        samples += other.samples;
+        return *this;
+    }
+};
+
+/**
+ * @class PerfCounters
+ * @brief Counts hardware events on the calling thread between start() and stop().
+ *
+ * Each event is opened as an independent counter. If the PMU has fewer
+ * counters than events, the kernel time-shares them and stop() scales each
+ * value by the fraction of the time its event was running. An event that
+ * never got a counter is reported as not counted (PerfSample::counted and
+ * unavailable()) rather than as zero.
+ */
+class PerfCounters {
+public:
+    inline PerfCounters() noexcept : m_error(0), m_unscheduled(0) {
+        for (int& fd : m_fds) {
+            fd = -1;
+        }
+#ifdef BENCH_HAVE_PERF_EVENTS
+        for (int i = 0; i < kPerfEventCount; ++i) {
+            m_fds[i] = open_event(static_cast<PerfEvent>(i));
+            if (m_fds[i] < 0 && m_error == 0) {
+                m_error = errno;
+            }
+        }
+#else
+        m_error = ENOSYS;
+#endif
+    }
+
+    inline ~PerfCounters() {
+#ifdef BENCH_HAVE_PERF_EVENTS
+        for (int fd : m_fds) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /// Whether any event could be opened; false means timing-only mode.
+    inline bool available() const noexcept {
+        for (int fd : m_fds) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Whether a given event was opened (stop() may still find it never ran).
+    inline bool counting(PerfEvent event) const noexcept { return m_fds[static_cast<int>(event)] >= 0; }
+
+    /**
+     * @brief Explain why events are missing.
+     *
+     * @return Empty if every event is counted, otherwise a one-line reason.
+     *         Includes events that opened but were never scheduled in a stop() so far.
+     */
+    inline std::string unavailable() const {
+        std::string unscheduled;
+        for (int i = 0; i < kPerfEventCount; ++i) {
+            if (m_unscheduled & (1u << i)) {
+                unscheduled += unscheduled.empty() ? "" : ", ";
+                unscheduled += perf_event_name(static_cast<PerfEvent>(i));
+            }
+        }
+        if (!unscheduled.empty()) {
+            unscheduled = "never scheduled on the PMU: " + unscheduled;
+        }
+        if (m_error == 0) {
+            return unscheduled;
+        }
+        std::string reason = std::string("perf_event_open: ") + std::strerror(m_error);
+        if (m_error == EACCES || m_error == EPERM) {
+            FILE* file = std::fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+            int level = 0;
+            if (file != nullptr) {
+                if (std::fscanf(file, "%d", &level) == 1) {
+                    reason += " (perf_event_paranoid=" + std::to_string(level) + ", need <= 2 without CAP_PERFMON)";
+                }
+                std::fclose(file);
+            }
+        }
+        reason += available() ? "; some events not counted" : "; timing only";
+        return unscheduled.empty() ? reason : reason + "; " + unscheduled;
+    }
+
+    /// Reset and enable the counters.
+    inline void start() noexcept {
+#ifdef BENCH_HAVE_PERF_EVENTS
+        for (int fd : m_fds) {
+            if (fd >= 0) {
+                ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            }
+        }
+        for (int fd : m_fds) {
+            if (fd >= 0) {
+                ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    /// Disable the counters and read them; events that never ran are left uncounted.
+    inline PerfSample stop() noexcept {
+        PerfSample sample;
+        sample.samples = 1;
+#ifdef BENCH_HAVE_PERF_EVENTS
+        for (int fd : m_fds) {
+            if (fd >= 0) {
+                ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+        for (int i = 0; i < kPerfEventCount; ++i) {
+            if (m_fds[i] < 0) {
+                continue;
+            }
+            uint64_t values[3] = {}; // value, time enabled, time running
+            if (::read(m_fds[i], values, sizeof(values)) != sizeof(values)) {
+                continue;
+            }
+            if (values[2] == 0) {
+                m_unscheduled |= 1u << i;
+                continue;
+            }
+            sample.counted[i] = true;
+            sample.values[i] = values[2] == values[1]
+                ? values[0]
+                : static_cast<uint64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+        }
+#endif
+        return sample;
+    }
+
+private:
+#ifdef BENCH_HAVE_PERF_EVENTS
+    static int open_event(PerfEvent event) noexcept {
+        struct perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        switch (event) {
+            case PerfEvent::LlcMisses:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+            case PerfEvent::L1dMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case PerfEvent::Instructions:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PerfEvent::Cycles:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case PerfEvent::BranchMisses:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+        }
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+    int m_fds[kPerfEventCount];  ///< One counter per PerfEvent, -1 if unavailable
+    int m_error;                 ///< errno of the first event that failed to open, or 0
+    unsigned m_unscheduled;      ///< Bit i set if PerfEvent i opened but a stop() found it never ran
+};
+
+/**
+ * @brief Per-call cost of a kernel: time plus each counted event.
+ */
+struct KernelCost {
+    double ns = 0;                              ///< Wall time per call
+    double events[kPerfEventCount] = {};        ///< Events per call, indexed by PerfEvent
+    bool counted[kPerfEventCount] = {};         ///< Whether events[i] was measured
+
+    /// Append ns_per_call and every counted event per call to a result.
+    inline void add_to(Result& result) const {
+        result.add("ns_per_call", ns);
+        for (int i = 0; i < kPerfEventCount; ++i) {
+            if (counted[i]) {
+                result.add(perf_event_name(static_cast<PerfEvent>(i)), events[i]);
+            }
+        }
+    }
+};
+
+/**
+ * @brief Run a kernel `calls` times under the counters and normalize per call.
+ *
+ * @param counters Counters opened on the calling thread.
+ * @param calls Number of calls.
+ * @param kernel Callable taking the call index.
+ * @return Per-call cost.
+ */
+template<typename Kernel>
+inline KernelCost measure_per_call(PerfCounters& counters, uint64_t calls, Kernel kernel) {
+    counters.start();
+    const uint64_t begin = now_ns();
+    for (uint64_t i = 0; i < calls; ++i) {
+        kernel(i);
+    }
+    const uint64_t end = now_ns();
+    const PerfSample sample = counters.stop();
+
+    KernelCost cost;
+    const double n = static_cast<double>(calls);
+    cost.ns = static_cast<double>(end - begin) / n;
+    for (int i = 0; i < kPerfEventCount; ++i) {
+        cost.counted[i] = sample.counted[i];
+        cost.events[i] = static_cast<double>(sample.values[i]) / n;
+    }
+    return cost;
+}
+
+} // namespace bench
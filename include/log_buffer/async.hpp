@@ -0,0 +1,241 @@
+#pragma once
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+#include "log_buffer/drain.hpp"
+
+namespace log_buffer {
+
+/**
+ * @brief Function that resumes a coroutine on the caller's executor.
+ *
+ * @param handle Coroutine to resume.
+ * @param context The pointer given to AsyncPool.
+ */
+using Scheduler = void (*)(std::coroutine_handle<> handle, void* context);
+
+class AsyncLogger;
+
+/**
+ * @class AsyncPool
+ * @brief Lets coroutines wait for buffers of a BufferPool instead of dropping.
+ *
+ * Installs itself as the pool's release hook. Each buffer the drainer hands
+ * back goes to the oldest waiting coroutine, which is then resumed through
+ * the scheduler (inline on the drainer thread if none is given). Works with
+ * any executor: the awaitables only ever call the Scheduler.
+ *
+ * Waiters are served in arrival order: an acquire that finds others already
+ * waiting queues behind them rather than taking the next freed buffer.
+ * Producers calling BufferPool::acquire() directly bypass the queue.
+ *
+ * @note Requires C++20. Only the waiting path takes a lock; acquiring a free
+ *       buffer is the pool's lock-free pop.
+ */
+class AsyncPool {
+public:
+    /**
+     * @brief Attach to a pool.
+     *
+     * @param pool Pool to wait on; must outlive this object.
+     * @param scheduler Resumes waiting coroutines, or nullptr to resume inline.
+     * @param context Passed to scheduler.
+     */
+    inline explicit AsyncPool(BufferPool& pool, Scheduler scheduler = nullptr, void* context = nullptr) noexcept
+        : m_pool(pool), m_scheduler(scheduler), m_context(context), m_waiting(0) {
+        m_pool.set_release_hook(&AsyncPool::on_release, this);
+    }
+
+    inline ~AsyncPool() { m_pool.set_release_hook(nullptr, nullptr); }
+
+    AsyncPool(const AsyncPool&) = delete;
+    AsyncPool& operator=(const AsyncPool&) = delete;
+
+    /// The underlying pool.
+    inline BufferPool& pool() noexcept { return m_pool; }
+
+private:
+    friend class AsyncLogger;
+
+    /// A suspended acquire or flush, stored in the awaiting coroutine's frame.
+    struct Waiter {
+        std::coroutine_handle<> handle;  ///< Coroutine to resume
+        Logger* logger;                  ///< Logger to attach a buffer to
+        const uint8_t* flushing;         ///< Sealed buffer to wait for, or nullptr once drained
+    };
+
+    static void on_release(const DetachedBuffer& buffer, void* context) noexcept {
+        static_cast<AsyncPool*>(context)->released(buffer.data);
+    }
+
+    inline void released(const uint8_t* data) noexcept {
+        std::deque<Waiter*> ready;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (Waiter* waiter : m_waiters) {
+                if (waiter->flushing == data) {
+                    waiter->flushing = nullptr; // drained; now it only needs a buffer
+                }
+            }
+            // Serve in arrival order; a flush still in the drain queue does not block others
+            for (auto it = m_waiters.begin(); it != m_waiters.end();) {
+                if ((*it)->flushing != nullptr) {
+                    ++it;
+                } else if (m_pool.acquire(*(*it)->logger)) {
+                    ready.push_back(*it);
+                    it = m_waiters.erase(it);
+                } else {
+                    break;
+                }
+            }
+            m_waiting.store(m_waiters.size(), std::memory_order_relaxed);
+        }
+        for (Waiter* waiter : ready) {
+            resume(waiter->handle);
+        }
+    }
+
+    /// Queue a waiter; m_mutex must be held.
+    inline void enqueue(Waiter* waiter) noexcept {
+        m_waiters.push_back(waiter);
+        m_waiting.store(m_waiters.size(), std::memory_order_relaxed);
+    }
+
+    inline void resume(std::coroutine_handle<> handle) noexcept {
+        if (m_scheduler != nullptr) {
+            m_scheduler(handle, m_context);
+        } else {
+            handle.resume();
+        }
+    }
+
+    BufferPool& m_pool;             ///< Pool being waited on
+    Scheduler m_scheduler;          ///< Resumes coroutines, or nullptr
+    void* m_context;                ///< Passed to m_scheduler
+    std::mutex m_mutex;             ///< Guards m_waiters
+    std::deque<Waiter*> m_waiters;  ///< Suspended acquires and flushes, oldest first
+    std::atomic<std::size_t> m_waiting; ///< Size of m_waiters, readable without the lock
+};
+
+/**
+ * @class AsyncLogger
+ * @brief Logger fed from an AsyncPool, with awaitable acquire and flush.
+ *
+ * @example
+ * @code
+ * Task produce(AsyncLogger& log) {
+ *     co_await log.acquire();           // suspends while every buffer is in flight
+ *     log.logger() << "request " << id;
+ *     co_await log.flush_async();       // resumes once drained, with a fresh buffer
+ * }
+ * @endcode
+ */
+class AsyncLogger {
+public:
+    /// Awaitable returned by acquire().
+    class AcquireAwaitable {
+    public:
+        inline bool await_ready() noexcept {
+            // Never overtake suspended coroutines: a freed buffer belongs to the oldest waiter
+            return m_logger.data() != nullptr
+                || (m_pool.m_waiting.load(std::memory_order_relaxed) == 0 && m_pool.pool().acquire(m_logger));
+        }
+
+        inline bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            std::lock_guard<std::mutex> lock(m_pool.m_mutex);
+            // Retry under the lock so a release between await_ready() and here is not missed
+            if (m_pool.m_waiters.empty() && m_pool.pool().acquire(m_logger)) {
+                return false;
+            }
+            m_waiter = AsyncPool::Waiter{handle, &m_logger, nullptr};
+            m_pool.enqueue(&m_waiter);
+            return true;
+        }
+
+        inline void await_resume() const noexcept {}
+
+    private:
+        friend class AsyncLogger;
+        inline AcquireAwaitable(AsyncPool& pool, Logger& logger) noexcept
+            : m_pool(pool), m_logger(logger), m_waiter{} {}
+
+        AsyncPool& m_pool;          ///< Pool to take the buffer from
+        Logger& m_logger;           ///< Logger to attach it to
+        AsyncPool::Waiter m_waiter; ///< Queue entry while suspended
+    };
+
+    /// Awaitable returned by flush_async().
+    class FlushAwaitable {
+    public:
+        inline bool await_ready() const noexcept { return false; }
+
+        inline bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            const uint8_t* sealed = m_logger.data();
+            BufferPool& pool = m_pool.pool();
+            Logger& logger = m_logger;
+            {
+                std::lock_guard<std::mutex> lock(m_pool.m_mutex);
+                m_waiter = AsyncPool::Waiter{handle, &m_logger, sealed};
+                m_pool.enqueue(&m_waiter);
+            }
+            if (sealed == nullptr) {
+                // Nothing to flush: just wait for a buffer
+                m_pool.released(nullptr);
+                return true;
+            }
+            // May resume this coroutine on the drainer thread before returning;
+            // nothing in the frame is touched afterwards
+            pool.seal(logger);
+            return true;
+        }
+
+        inline void await_resume() const noexcept {}
+
+    private:
+        friend class AsyncLogger;
+        inline FlushAwaitable(AsyncPool& pool, Logger& logger) noexcept
+            : m_pool(pool), m_logger(logger), m_waiter{} {}
+
+        AsyncPool& m_pool;          ///< Pool the buffer belongs to
+        Logger& m_logger;           ///< Logger being flushed
+        AsyncPool::Waiter m_waiter; ///< Queue entry while suspended
+    };
+
+    /**
+     * @brief Construct a logger without a buffer; co_await acquire() first.
+     *
+     * @param pool Pool to take buffers from; must outlive this object.
+     */
+    inline explicit AsyncLogger(AsyncPool& pool) noexcept : m_pool(pool), m_logger(nullptr, 0) {}
+
+    /// The Logger to write to; holds a pool buffer after acquire() or flush_async().
+    inline Logger& logger() noexcept { return m_logger; }
+
+    /**
+     * @brief Attach a free buffer, suspending while all buffers are in flight.
+     *
+     * Completes immediately if the logger already holds a buffer.
+     */
+    inline AcquireAwaitable acquire() noexcept { return AcquireAwaitable(m_pool, m_logger); }
+
+    /**
+     * @brief Seal the current buffer and resume once the drainer has consumed it.
+     *
+     * On resumption the logger holds a fresh buffer, so writing can continue.
+     */
+    inline FlushAwaitable flush_async() noexcept { return FlushAwaitable(m_pool, m_logger); }
+
+private:
+    AsyncPool& m_pool;  ///< Source of buffers
+    Logger m_logger;    ///< Writes into the current buffer
+};
+
+} // namespace log_buffer
+
+#endif // C++20 coroutines
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "log_buffer/decoder.hpp"
+#include "log_buffer/logger.hpp"
+#include "log_buffer/record.hpp"
+
+namespace log_buffer {
+
+/**
+ * @brief Check whether a character belongs to a search token.
+ *
+ * Tokens are maximal runs of letters, digits, '_' and '-', so request IDs,
+ * UUIDs and numbers are single tokens and punctuation separates them.
+ */
+inline bool is_token_char(char c) noexcept {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+}
+
+/**
+ * @brief Call f(std::string_view) for every token of a text.
+ *
+ * @param text Text to split (e.g. one decoded field).
+ * @param f Callback receiving each token, in order.
+ */
+template <typename F>
+inline void for_each_token(std::string_view text, F&& f) {
+    std::size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && !is_token_char(text[i])) {
+            ++i;
+        }
+        const std::size_t start = i;
+        while (i < text.size() && is_token_char(text[i])) {
+            ++i;
+        }
+        if (i > start) {
+            f(text.substr(start, i - start));
+        }
+    }
+}
+
+/**
+ * @brief Hash a token the way block summaries do.
+ *
+ * @param token Token bytes.
+ * @return 64-bit hash.
+ */
+uint64_t hash_token(std::string_view token) noexcept;
+
+/**
+ * @brief Test a block summary's filter for a token hash.
+ *
+ * @param header Decoded summary header (see decode_block_summary()).
+ * @param filter Filter bits of the summary.
+ * @param hash hash_token() of the token.
+ * @return false if the block certainly holds no record with the token.
+ */
+bool block_may_contain(const BlockSummaryHeader& header, const uint8_t* filter, uint64_t hash) noexcept;
+
+/**
+ * @class BlockSummarizer
+ * @brief Builds a Bloom filter of the tokens in a block of records.
+ *
+ * Every string field of every RecordType::Log record is split into tokens
+ * (see for_each_token()) and hashed into a filter sized for the block's
+ * distinct tokens, about bits_per_token bits each. The result is one framed
+ * RecordType::BlockSummary record, written ahead of the block so offline
+ * search can test it and skip the block (see search_blocks()).
+ *
+ * Runs on the drainer, not on producers: Drainer::set_block_summarizer()
+ * summarizes every drained buffer before it goes to the sink. Scratch
+ * storage keeps its capacity between blocks, so once it has grown to the
+ * largest block nothing is allocated.
+ *
+ * @example
+ * @code
+ * BlockSummarizer summarizer;
+ * drainer.set_block_summarizer(&summarizer);
+ * // Offline: search_blocks(dump.data(), dump.size(), "req-1234", ...)
+ * @endcode
+ *
+ * @note Thread Safety: not thread-safe; use one summarizer per drainer.
+ */
+class BlockSummarizer {
+public:
+    /**
+     * @brief Construct a summarizer.
+     *
+     * With 10 bits per token about 1% of the blocks that lack a token still
+     * pass its filter.
+     *
+     * @param format StringFormat the producers write fields with.
+     * @param bits_per_token Filter bits per distinct token, at least 1.
+     * @param max_filter_bytes Largest filter; blocks with more tokens get a
+     *        fuller, less selective filter.
+     */
+    explicit BlockSummarizer(StringFormat format = StringFormat::NulTerminated, uint32_t bits_per_token = 10,
+                             std::size_t max_filter_bytes = 16 * 1024);
+
+    BlockSummarizer(const BlockSummarizer&) = delete;
+    BlockSummarizer& operator=(const BlockSummarizer&) = delete;
+
+    /**
+     * @brief Summarize one block.
+     *
+     * @param data Block bytes, as handed to the sink.
+     * @param size Number of bytes.
+     */
+    void summarize(const uint8_t* data, std::size_t size);
+
+    /// The summary record built by the last summarize() call.
+    inline const uint8_t* data() const noexcept { return m_record.data(); }
+
+    /// Size of the summary record in bytes (a multiple of kRecordAlignment).
+    inline std::size_t size() const noexcept { return m_record.size(); }
+
+private:
+    StringFormat m_format;           ///< Field encoding of the summarized records
+    uint32_t m_bits_per_token;       ///< Filter bits per distinct token
+    uint8_t m_hashes;                ///< Bits set per token
+    std::size_t m_max_filter_bits;   ///< Largest filter (a power of two)
+    std::vector<uint64_t> m_tokens;  ///< Token hashes of the current block
+    std::vector<uint8_t> m_record;   ///< Summary record
+};
+
+/**
+ * @struct BlockSearchStats
+ * @brief What search_blocks() read and skipped.
+ */
+struct BlockSearchStats {
+    uint64_t blocks = 0;         ///< Block summaries found
+    uint64_t skipped = 0;        ///< Blocks whose filter ruled the query out
+    uint64_t bytes_skipped = 0;  ///< Bytes of the skipped blocks
+    uint64_t records = 0;        ///< Log records decoded
+    uint64_t matches = 0;        ///< Records passed to the callback
+};
+
+/**
+ * @brief Find the records holding every token of a query, skipping blocks that cannot match.
+ *
+ * Walks a dump written with block summaries. A block whose filter lacks any
+ * query token is skipped with RecordReader::seek(), so its pages are never
+ * read from a mapped file; candidate blocks, and data without summaries,
+ * are decoded and each record's tokens checked exactly.
+ *
+ * @param data Dump bytes (e.g. MappedDump::data()).
+ * @param size Number of bytes.
+ * @param query Text whose tokens must all appear as whole tokens in a record.
+ * @param format StringFormat the records were written with.
+ * @param on_match Called with each matching RecordType::Log record, in file order.
+ * @return Counts of blocks and records read; matches is 0 if query has no tokens.
+ */
+BlockSearchStats search_blocks(const uint8_t* data, std::size_t size, std::string_view query, StringFormat format,
+                               const std::function<void(const RecordView&)>& on_match);
+
+} // namespace log_buffer
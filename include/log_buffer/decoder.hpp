@@ -0,0 +1,523 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#else
+/// Scatter-gather element, layout-compatible with POSIX struct iovec
+struct iovec {
+    void* iov_base;
+    std::size_t iov_len;
+};
+#endif
+
+#include "log_buffer/encoding.hpp"
+#include "log_buffer/logger.hpp"
+#include "log_buffer/record.hpp"
+#include "log_buffer/site_sketch.hpp"
+
+namespace log_buffer {
+
+/**
+ * @struct RecordView
+ * @brief Non-owning view of one framed record inside a buffer.
+ *
+ * Points directly into the buffer being read; valid only while that buffer is.
+ */
+struct RecordView {
+    const uint8_t* data;      ///< Start of the record (its RecordHeader)
+    std::size_t size;         ///< Header plus payload bytes
+    RecordType type;          ///< Record type (flags removed)
+    Level level;              ///< Record severity
+    uint16_t tag;             ///< Record tag
+    bool has_sequence;        ///< Whether the record's absolute sequence number is known
+    uint64_t sequence;        ///< Absolute sequence number (if has_sequence)
+    uint64_t sequence_gap;    ///< Sequence numbers skipped since the previous record of the buffer
+    bool has_metadata;        ///< Whether site and timestamp_us were recorded (RecordMetadata)
+    uint32_t site;            ///< Call-site/format ID (if has_metadata)
+    uint32_t timestamp_us;    ///< Microseconds since BufferHeader::steady_ns (if has_metadata)
+    const uint8_t* payload_data;  ///< First payload byte
+    std::size_t payload_length;   ///< Number of payload bytes
+
+    /// Pointer to the first payload byte.
+    inline const uint8_t* payload() const noexcept { return payload_data; }
+
+    /// Number of payload bytes.
+    inline std::size_t payload_size() const noexcept { return payload_length; }
+
+    /// The payload bytes as a view into the buffer.
+    inline std::string_view payload_view() const noexcept {
+        return std::string_view(reinterpret_cast<const char*>(payload_data), payload_length);
+    }
+};
+
+/**
+ * @class FieldReader
+ * @brief Zero-copy reader for the fields of a record payload.
+ *
+ * Strings come back as string_views into the buffer and integers are parsed
+ * in place, so decoding a mapped dump allocates nothing. The reader must be
+ * told the StringFormat the fields were written with.
+ *
+ * @example
+ * @code
+ * FieldReader fields(record, StringFormat::LengthPrefixed);
+ * std::string_view name;
+ * int64_t value = 0;
+ * if (fields.read_string(name) && fields.read_int(value)) { ... }
+ * @endcode
+ */
+class FieldReader {
+public:
+    /**
+     * @brief Construct a reader over raw field bytes.
+     *
+     * @param data First field byte.
+     * @param size Number of bytes.
+     * @param format Encoding of string and integer fields.
+     */
+    inline FieldReader(const uint8_t* data, std::size_t size,
+                       StringFormat format = StringFormat::NulTerminated) noexcept
+        : m_pos(data), m_end(data + size), m_format(format) {}
+
+    /**
+     * @brief Construct a reader over a record's payload.
+     *
+     * @param record The record.
+     * @param format Encoding of string and integer fields.
+     */
+    inline explicit FieldReader(const RecordView& record,
+                                StringFormat format = StringFormat::NulTerminated) noexcept
+        : FieldReader(record.payload(), record.payload_size(), format) {}
+
+    /**
+     * @brief Read the next string field.
+     *
+     * @param out Receives a view of the string bytes (terminator/prefix excluded).
+     * @return false if the field is truncated; the reader does not advance.
+     */
+    inline bool read_string(std::string_view& out) noexcept {
+        if (m_format == StringFormat::LengthPrefixed) {
+            const uint8_t* next = decode_string(m_pos, m_end, out);
+            if (next == nullptr) {
+                return false;
+            }
+            m_pos = next;
+            return true;
+        }
+        const void* nul = std::memchr(m_pos, '\0', static_cast<std::size_t>(m_end - m_pos));
+        if (nul == nullptr) {
+            return false;
+        }
+        const uint8_t* term = static_cast<const uint8_t*>(nul);
+        out = std::string_view(reinterpret_cast<const char*>(m_pos), static_cast<std::size_t>(term - m_pos));
+        m_pos = term + 1;
+        return true;
+    }
+
+    /**
+     * @brief Read the next integer field.
+     *
+     * Accepts every IntFormat: "0x"/"0X" selects base 16 and a leading '0'
+     * base 8, as written by Logger::log().
+     *
+     * @param out Receives the value.
+     * @return false if the field is truncated, not a number or out of range
+     *         for T; the reader does not advance.
+     */
+    template<typename T>
+    inline std::enable_if_t<std::is_integral_v<T>, bool> read_int(T& out) noexcept {
+        const uint8_t* saved = m_pos;
+        std::string_view text;
+        if (!read_string(text)) {
+            return false;
+        }
+        int base = 10;
+        if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+            base = 16;
+            text.remove_prefix(2);
+        } else if (text.size() > 1 && text[0] == '0') {
+            base = 8;
+            text.remove_prefix(1);
+        }
+        const auto result = std::from_chars(text.data(), text.data() + text.size(), out, base);
+        if (result.ec != std::errc{} || result.ptr != text.data() + text.size()) {
+            m_pos = saved;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Take the next raw bytes (e.g. from Logger::log(const uint8_t*, size_t)).
+     *
+     * @param size Number of bytes.
+     * @param out Receives a pointer to them.
+     * @return false if fewer bytes remain.
+     */
+    inline bool read_bytes(std::size_t size, const uint8_t*& out) noexcept {
+        if (size > remaining()) {
+            return false;
+        }
+        out = m_pos;
+        m_pos += size;
+        return true;
+    }
+
+    /// Number of unread bytes.
+    inline std::size_t remaining() const noexcept { return static_cast<std::size_t>(m_end - m_pos); }
+
+private:
+    const uint8_t* m_pos;   ///< Next unread byte
+    const uint8_t* m_end;   ///< One past the last byte
+    StringFormat m_format;  ///< Field encoding
+};
+
+/**
+ * @class RecordReader
+ * @brief Forward iterator over the framed records in a buffer.
+ *
+ * Walks records by their size fields, skipping padding slots, so the cost is
+ * proportional to the number of records rather than the number of bytes.
+ * Sequence deltas are resolved to absolute numbers along the way, and
+ * missing_records() sums the numbers that were skipped (records the
+ * producer dropped). A BufferHeader at offset 0 or at any later record
+ * boundary (buffers concatenated into one dump) is skipped and becomes the
+ * current buffer_header().
+ *
+ * @example
+ * @code
+ * RecordReader reader(logger);
+ * RecordView record;
+ * while (reader.next(record)) {
+ *     // use record.level, record.tag, record.payload()
+ * }
+ * @endcode
+ */
+class RecordReader {
+public:
+    /**
+     * @brief Construct a reader over a buffer of framed records.
+     *
+     * If the buffer starts with a BufferHeader, it is parsed (see
+     * buffer_header()) and reading starts after it.
+     *
+     * @param data Pointer to the start of the buffer (offset 0 of the Logger that wrote it).
+     * @param size Number of valid bytes in the buffer.
+     */
+    RecordReader(const uint8_t* data, std::size_t size) noexcept;
+
+    /**
+     * @brief Construct a reader over the bytes written so far by a Logger.
+     *
+     * @param logger The Logger whose buffer to read.
+     */
+    explicit RecordReader(const Logger& logger) noexcept;
+
+    /**
+     * @brief Advance to the next record.
+     *
+     * @param record Receives the record on success.
+     * @return true if a record was read, false at the end of the buffer or if a
+     *         malformed header was found (see malformed()).
+     */
+    bool next(RecordView& record) noexcept;
+
+    /**
+     * @brief Get the offset of the next unread byte.
+     *
+     * @return Offset from the start of the buffer.
+     */
+    inline std::size_t offset() const noexcept { return m_offset; }
+
+    /**
+     * @brief Reposition the reader.
+     *
+     * @param offset Offset of a record boundary from the start of the buffer.
+     */
+    inline void seek(std::size_t offset) noexcept {
+        m_offset = offset < m_records_start ? m_records_start : offset;
+        m_malformed = false;
+        m_have_sequence = false;
+    }
+
+    /**
+     * @brief Check whether reading stopped at a malformed header.
+     *
+     * @return true if a header with an impossible size was found.
+     */
+    inline bool malformed() const noexcept { return m_malformed; }
+
+    /**
+     * @brief Get the total number of sequence numbers skipped so far.
+     *
+     * Counts gaps between sequenced records of this buffer; the numbering
+     * across buffers is checked with SequenceTracker.
+     *
+     * @return Records the producer numbered but did not commit.
+     */
+    inline uint64_t missing_records() const noexcept { return m_missing_records; }
+
+    /**
+     * @brief Get the buffer header, if the buffer has one.
+     *
+     * @return Pointer to a copy of the header, or nullptr.
+     */
+    inline const BufferHeader* buffer_header() const noexcept {
+        return m_have_header ? &m_header : nullptr;
+    }
+
+private:
+    const uint8_t* m_data;  ///< Start of the buffer
+    std::size_t m_size;     ///< Valid bytes in the buffer
+    std::size_t m_offset;   ///< Offset of the next record boundary
+    bool m_malformed;       ///< Flag indicating a malformed header was found
+    bool m_have_sequence;   ///< Flag indicating m_last_sequence is valid
+    uint64_t m_last_sequence;   ///< Sequence number of the previous sequenced record
+    uint64_t m_missing_records; ///< Sum of sequence gaps seen so far
+    std::size_t m_records_start; ///< Offset of the first record (after any buffer header)
+    bool m_have_header;     ///< Flag indicating m_header is valid
+    BufferHeader m_header;  ///< Most recently read buffer header
+};
+
+/**
+ * @class MappedDump
+ * @brief Read-only memory mapping of a dump file.
+ *
+ * Lets RecordReader, RecordView and FieldReader work directly on the file
+ * contents through the page cache, without reading them into memory first.
+ * Move-only; the mapping is released by close() or the destructor.
+ */
+class MappedDump {
+public:
+    inline MappedDump() noexcept : m_data(nullptr), m_size(0) {}
+    inline ~MappedDump() { close(); }
+
+    MappedDump(const MappedDump&) = delete;
+    MappedDump& operator=(const MappedDump&) = delete;
+
+    inline MappedDump(MappedDump&& other) noexcept : m_data(other.m_data), m_size(other.m_size) {
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    inline MappedDump& operator=(MappedDump&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_data = other.m_data;
+            m_size = other.m_size;
+            other.m_data = nullptr;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Map a file.
+     *
+     * @param path File to map.
+     * @return true on success (an empty file maps to size() == 0), false if it
+     *         cannot be opened or mapped, or on platforms without mmap.
+     */
+    bool open(const char* path) noexcept;
+
+    /**
+     * @brief Release the mapping.
+     */
+    void close() noexcept;
+
+    /**
+     * @brief Turn off readahead for readers that jump around the file.
+     *
+     * open() advises sequential access; call this before skipping through
+     * the file (e.g. search_blocks()) so skipped ranges are never read in.
+     */
+    void advise_random() noexcept;
+
+    /// First byte of the file, or nullptr if nothing is mapped.
+    inline const uint8_t* data() const noexcept { return m_data; }
+
+    /// Size of the file in bytes.
+    inline std::size_t size() const noexcept { return m_size; }
+
+private:
+    const uint8_t* m_data;  ///< Mapped file contents
+    std::size_t m_size;     ///< Mapped length
+};
+
+/**
+ * @class SequenceTracker
+ * @brief Detects lost records across buffers from one producer.
+ *
+ * Feed it the sequence numbers of one producer's records in the order they
+ * were decoded (e.g. across the buffers of a dump); it reports how many
+ * numbers were skipped.
+ */
+class SequenceTracker {
+public:
+    inline SequenceTracker() noexcept
+        : m_started(false), m_expected(0), m_received(0), m_missing(0), m_reordered(0) {}
+
+    /**
+     * @brief Account for the next decoded sequence number.
+     *
+     * @param sequence The record's absolute sequence number.
+     * @return Number of sequence numbers skipped just before this one.
+     */
+    inline uint64_t observe(uint64_t sequence) noexcept {
+        ++m_received;
+        uint64_t skipped = 0;
+        if (!m_started) {
+            m_started = true;
+        } else if (sequence >= m_expected) {
+            skipped = sequence - m_expected;
+        } else {
+            ++m_reordered; // duplicate or out of order; not a loss
+            return 0;
+        }
+        m_missing += skipped;
+        m_expected = sequence + 1;
+        return skipped;
+    }
+
+    /// Number of sequence numbers observed.
+    inline uint64_t received() const noexcept { return m_received; }
+
+    /// Number of sequence numbers skipped in total.
+    inline uint64_t missing() const noexcept { return m_missing; }
+
+    /// Number of sequence numbers that went backwards.
+    inline uint64_t reordered() const noexcept { return m_reordered; }
+
+private:
+    bool m_started;         ///< Flag indicating a first number was observed
+    uint64_t m_expected;    ///< Next sequence number expected
+    uint64_t m_received;    ///< Numbers observed
+    uint64_t m_missing;     ///< Numbers skipped
+    uint64_t m_reordered;   ///< Numbers that went backwards
+};
+
+/**
+ * @struct RecordFilter
+ * @brief Selects records by minimum level and, optionally, by tag.
+ */
+struct RecordFilter {
+    Level min_level = Level::Trace;   ///< Records below this level are skipped
+    std::optional<uint16_t> tag;      ///< If set, only records with this tag match
+
+    /**
+     * @brief Check whether a record passes the filter.
+     *
+     * @param record The record to test.
+     * @return true if the record matches.
+     */
+    inline bool matches(const RecordView& record) const noexcept {
+        return record.type == RecordType::Log && record.level >= min_level && (!tag || record.tag == *tag);
+    }
+};
+
+/**
+ * @brief Parse the BufferHeader at the start of a buffer.
+ *
+ * @param data Pointer to the start of the buffer.
+ * @param size Number of valid bytes in the buffer.
+ * @param header Receives the header on success.
+ * @return true if the buffer starts with a header this library can read.
+ */
+bool read_buffer_header(const uint8_t* data, std::size_t size, BufferHeader& header) noexcept;
+
+/**
+ * @brief Read the loss counts from a RecordType::Gap record.
+ *
+ * @param record The record to decode.
+ * @param records Receives the number of dropped records.
+ * @param bytes Receives the number of dropped bytes.
+ * @return true if record is a well-formed gap record.
+ */
+bool decode_gap(const RecordView& record, uint64_t& records, uint64_t& bytes) noexcept;
+
+/**
+ * @brief Read the heaviest sites from a RecordType::SiteStats record.
+ *
+ * @param record The record to decode (see SiteSketch::emit()).
+ * @param out Receives up to max entries, heaviest first.
+ * @param max Capacity of out.
+ * @param count Receives the number of entries written to out.
+ * @param total Receives the total weight counted by the sketch.
+ * @return true if record is a well-formed site stats record.
+ */
+bool decode_site_stats(const RecordView& record, SiteCount* out, std::size_t max, std::size_t& count,
+                       uint64_t& total) noexcept;
+
+/**
+ * @brief Read a RecordType::BlockSummary record.
+ *
+ * @param record The record to decode (see BlockSummarizer).
+ * @param header Receives the summary header.
+ * @param filter Receives a pointer to the filter bits, inside the record.
+ * @return true if record is a well-formed block summary record.
+ */
+bool decode_block_summary(const RecordView& record, BlockSummaryHeader& header, const uint8_t*& filter) noexcept;
+
+/**
+ * @brief Append a buffer's records to a string as text, one line per record.
+ *
+ * Lines read "<level> <tag>[ #<sequence>][ @<timestamp_us>us site=<site>]: <fields>",
+ * with fields separated by spaces and control bytes escaped as \xHH. Gap,
+ * site stats and block summary records are spelled out; padding and buffer
+ * headers are skipped.
+ * Used as the default formatter of FormatDrainer.
+ *
+ * @param data Start of a buffer of framed records (may begin with a BufferHeader).
+ * @param size Number of valid bytes.
+ * @param out String to append to.
+ * @param format Encoding the string fields were written with.
+ */
+void format_text(const uint8_t* data, std::size_t size, std::string& out,
+                 StringFormat format = StringFormat::NulTerminated);
+
+/**
+ * @brief Build a scatter-gather list of the records that match a filter.
+ *
+ * Each iovec points straight into the buffer and covers one or more adjacent
+ * matching records including their alignment padding, so the gathered bytes
+ * are themselves a valid record stream. Adjacent matches are coalesced into
+ * one entry. The result can be handed to writev() or io_uring without copying.
+ * Records keep their original sequence deltas, so sequence numbers decoded
+ * from the gathered bytes are exact only where no record was filtered out.
+ *
+ * @param data Pointer to the start of a buffer of framed records.
+ * @param size Number of valid bytes in the buffer.
+ * @param filter Records to include.
+ * @param iov Output array.
+ * @param iov_count Capacity of the output array.
+ * @param offset In: offset to start reading at (0 for the whole buffer).
+ *               Out: offset to resume from; equals size once everything was gathered
+ *               or if the rest of the buffer is malformed.
+ * @return Number of iovec entries filled.
+ */
+std::size_t gather_records(const uint8_t* data, std::size_t size, const RecordFilter& filter,
+                           struct iovec* iov, std::size_t iov_count, std::size_t& offset) noexcept;
+
+/**
+ * @brief Build a scatter-gather list of the matching records in a Logger's buffer.
+ *
+ * @param logger The Logger whose buffer to read.
+ * @param filter Records to include.
+ * @param iov Output array.
+ * @param iov_count Capacity of the output array.
+ * @param offset In/out resume offset, as for the buffer overload.
+ * @return Number of iovec entries filled.
+ */
+std::size_t gather_records(const Logger& logger, const RecordFilter& filter,
+                           struct iovec* iov, std::size_t iov_count, std::size_t& offset) noexcept;
+
+} // namespace log_buffer
@@ -0,0 +1,444 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log_buffer/block_summary.hpp"
+#include "log_buffer/logger.hpp"
+#include "log_buffer/site_sketch.hpp"
+
+namespace log_buffer {
+
+/**
+ * @brief Size used to keep independently written atomics on separate cache lines.
+ */
+inline constexpr std::size_t kCacheLineSize = 64;
+
+/**
+ * @class Notifier
+ * @brief Coalescing wakeup from many producers to one consumer.
+ *
+ * notify() sets a pending flag and only enters the kernel (futex wake) if the
+ * consumer is parked and the flag was clear, so a burst of signals costs one
+ * wakeup. wait() spins for an adaptive number of iterations before parking:
+ * the spin budget doubles whenever a signal arrives while spinning and halves
+ * whenever the consumer has to park, so busy periods are served with spin
+ * latency and idle periods cost no CPU.
+ *
+ * @note Thread Safety: notify() may be called from any number of threads;
+ *       wait() from one thread at a time.
+ */
+class Notifier {
+public:
+    static constexpr uint32_t kMinSpin = 16;        ///< Lower bound of the adaptive spin budget
+    static constexpr uint32_t kMaxSpin = 1u << 14;  ///< Upper bound of the adaptive spin budget
+
+    inline Notifier() noexcept : m_state(0), m_spin(kMinSpin) {}
+
+    Notifier(const Notifier&) = delete;
+    Notifier& operator=(const Notifier&) = delete;
+
+    /**
+     * @brief Signal the consumer.
+     *
+     * Cheap if a signal is already pending: one atomic OR and no system call.
+     */
+    void notify() noexcept;
+
+    /**
+     * @brief Wait for a signal and consume it.
+     *
+     * @param timeout Maximum time to park.
+     * @return true if a signal was consumed, false on timeout.
+     */
+    bool wait(std::chrono::nanoseconds timeout) noexcept;
+
+    /**
+     * @brief Get the current spin budget.
+     *
+     * @return Spin iterations the next wait() will try before parking.
+     */
+    inline uint32_t spin_limit() const noexcept { return m_spin; }
+
+private:
+    static constexpr uint32_t kPending = 1; ///< A signal has not been consumed yet
+    static constexpr uint32_t kParked = 2;  ///< The consumer is (about to be) asleep
+
+    alignas(kCacheLineSize) std::atomic<uint32_t> m_state; ///< kPending | kParked bits (futex word)
+    uint32_t m_spin;  ///< Adaptive spin budget, only touched by the consumer
+};
+
+/**
+ * @class BufferQueue
+ * @brief Bounded lock-free multi-producer/multi-consumer queue of buffers.
+ *
+ * Array-based queue with a per-cell sequence number (D. Vyukov's design):
+ * push and pop each take one CAS on their own cache line, and never block.
+ */
+class BufferQueue {
+public:
+    /**
+     * @brief Construct a queue.
+     *
+     * @param capacity Minimum number of entries; rounded up to a power of two.
+     */
+    explicit BufferQueue(std::size_t capacity);
+
+    BufferQueue(const BufferQueue&) = delete;
+    BufferQueue& operator=(const BufferQueue&) = delete;
+
+    /**
+     * @brief Add a buffer at the back.
+     *
+     * @param buffer The buffer.
+     * @return false if the queue is full.
+     */
+    bool push(const DetachedBuffer& buffer) noexcept;
+
+    /**
+     * @brief Remove the buffer at the front.
+     *
+     * @param buffer Receives the buffer.
+     * @return false if the queue is empty.
+     */
+    bool pop(DetachedBuffer& buffer) noexcept;
+
+    /// Number of entries the queue can hold.
+    inline std::size_t capacity() const noexcept { return m_mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence; ///< Turn number of the next push/pop of this cell
+        DetachedBuffer buffer;             ///< Stored buffer
+    };
+
+    std::unique_ptr<Cell[]> m_cells;    ///< Ring storage
+    std::size_t m_mask;                 ///< capacity() - 1
+    alignas(kCacheLineSize) std::atomic<std::size_t> m_push_position; ///< Next cell to push
+    alignas(kCacheLineSize) std::atomic<std::size_t> m_pop_position;  ///< Next cell to pop
+};
+
+/**
+ * @brief Callback run by BufferPool::release() after a buffer became free again.
+ *
+ * @param buffer The buffer that was returned (size is the drained size).
+ * @param context The pointer given to BufferPool::set_release_hook().
+ */
+using ReleaseHook = void (*)(const DetachedBuffer& buffer, void* context);
+
+/**
+ * @class BufferPool
+ * @brief Fixed set of equally sized buffers cycling between producers and a drainer.
+ *
+ * Producers acquire() an empty buffer into their Logger and seal() it when it
+ * is full, which queues it for draining and signals notifier(). The drainer
+ * pops sealed buffers with pop_sealed() and hands them back with release().
+ * No memory is allocated after construction.
+ *
+ * @example
+ * @code
+ * BufferPool pool(8, 64 * 1024);
+ * Drainer drainer(pool, [&](const uint8_t* data, std::size_t size) { write(fd, data, size); });
+ * drainer.start();
+ * Logger logger(nullptr, 0);
+ * pool.acquire(logger);
+ * // ... log; when the buffer runs full:
+ * pool.seal(logger);
+ * pool.acquire(logger);
+ * @endcode
+ */
+class BufferPool {
+public:
+    /**
+     * @brief Allocate the buffers.
+     *
+     * @param count Number of buffers.
+     * @param buffer_size Capacity of each buffer in bytes.
+     */
+    BufferPool(std::size_t count, std::size_t buffer_size);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief Attach an empty buffer to a Logger.
+     *
+     * @param logger Logger to attach it to; should not hold a buffer.
+     * @return false if every buffer is in use (the logger is left unchanged).
+     */
+    bool acquire(Logger& logger) noexcept;
+
+    /**
+     * @brief Detach a Logger's buffer and queue it for draining.
+     *
+     * Sealing is one of the two points where producers signal the drainer
+     * (the other being Logger::set_notifier()).
+     *
+     * @param logger Logger holding a buffer from this pool.
+     * @return false if the logger held no buffer.
+     */
+    bool seal(Logger& logger) noexcept;
+
+    /**
+     * @brief Take the oldest sealed buffer.
+     *
+     * @param buffer Receives the buffer.
+     * @return false if none is waiting.
+     */
+    inline bool pop_sealed(DetachedBuffer& buffer) noexcept { return m_sealed.pop(buffer); }
+
+    /**
+     * @brief Return a drained buffer to the pool.
+     *
+     * @param buffer A buffer obtained from pop_sealed().
+     */
+    void release(const DetachedBuffer& buffer) noexcept;
+
+    /**
+     * @brief Run a callback each time a buffer is released.
+     *
+     * Used to resume producers waiting for a free buffer (see async.hpp).
+     * The hook runs on the releasing (drainer) thread. Set it before buffers
+     * start cycling.
+     *
+     * @param hook Callback, or nullptr to remove it.
+     * @param context Passed to hook.
+     */
+    inline void set_release_hook(ReleaseHook hook, void* context) noexcept {
+        m_release_hook = hook;
+        m_release_context = context;
+    }
+
+    /// Notifier signalled by seal().
+    inline Notifier& notifier() noexcept { return m_notifier; }
+
+    /// Number of buffers.
+    inline std::size_t count() const noexcept { return m_count; }
+
+    /// Capacity of each buffer.
+    inline std::size_t buffer_size() const noexcept { return m_buffer_size; }
+
+private:
+    std::size_t m_count;                 ///< Number of buffers
+    std::size_t m_buffer_size;           ///< Capacity of each buffer
+    std::unique_ptr<uint8_t[]> m_storage; ///< Backing memory for all buffers
+    BufferQueue m_free;                  ///< Buffers ready for acquire()
+    BufferQueue m_sealed;                ///< Buffers waiting to be drained
+    Notifier m_notifier;                 ///< Wakes the drainer
+    ReleaseHook m_release_hook;          ///< Called after release(), or nullptr
+    void* m_release_context;             ///< Passed to m_release_hook
+};
+
+/**
+ * @class Drainer
+ * @brief Background thread that hands sealed buffers to a sink.
+ *
+ * Waits on the pool's Notifier, so it reacts within the spin window while
+ * producers are busy and sleeps when they are not. The timeout bounds how
+ * long a buffer can wait if a producer seals without the drainer noticing.
+ */
+class Drainer {
+public:
+    /// Called with the written bytes of each sealed buffer, on the drainer thread.
+    using Sink = std::function<void(const uint8_t* data, std::size_t size)>;
+
+    /**
+     * @brief Construct a drainer; call start() to run it.
+     *
+     * @param pool Pool to drain; must outlive the drainer.
+     * @param sink Receives the contents of each sealed buffer.
+     * @param timeout Longest time to park between checks.
+     */
+    Drainer(BufferPool& pool, Sink sink,
+            std::chrono::nanoseconds timeout = std::chrono::milliseconds(100));
+
+    /**
+     * @brief Stop the thread (draining what is left) if still running.
+     */
+    ~Drainer();
+
+    Drainer(const Drainer&) = delete;
+    Drainer& operator=(const Drainer&) = delete;
+
+    /**
+     * @brief Start the drainer thread.
+     */
+    void start();
+
+    /**
+     * @brief Drain the remaining sealed buffers and join the thread.
+     */
+    void stop() noexcept;
+
+    /**
+     * @brief Drain every sealed buffer on the calling thread.
+     *
+     * @return Number of buffers drained.
+     */
+    std::size_t drain() noexcept;
+
+    /**
+     * @brief Count drained records per call site and report the heaviest.
+     *
+     * Every drained buffer is added to the sketch (SiteSketch::add_buffer(),
+     * weighted by record size) before it goes to the sink. Once per interval,
+     * and when the drainer stops, the heaviest sites are written to the sink
+     * as a buffer holding one RecordType::SiteStats record, and the sketch is
+     * cleared for the next interval. Call before start().
+     *
+     * @param sketch Sketch to feed, or nullptr to disable; must outlive the drainer.
+     * @param interval Reporting interval.
+     */
+    void set_site_sketch(SiteSketch* sketch, std::chrono::nanoseconds interval);
+
+    /**
+     * @brief Write a token filter ahead of every drained buffer.
+     *
+     * Each buffer is summarized (BlockSummarizer::summarize()) and the sink
+     * receives the RecordType::BlockSummary record immediately before the
+     * buffer itself, so a dump of the sink's output can be searched with
+     * search_blocks(). Call before start().
+     *
+     * @param summarizer Summarizer to use, or nullptr to disable; must outlive the drainer.
+     */
+    inline void set_block_summarizer(BlockSummarizer* summarizer) noexcept { m_summarizer = summarizer; }
+
+    /// Number of buffers drained so far.
+    inline uint64_t drained() const noexcept { return m_drained.load(std::memory_order_relaxed); }
+
+private:
+    void run() noexcept;
+
+    /// Send the sketch's heaviest sites to the sink and clear it.
+    void emit_site_stats() noexcept;
+
+    BufferPool& m_pool;                 ///< Pool being drained
+    Sink m_sink;                        ///< Consumer of buffer contents
+    std::chrono::nanoseconds m_timeout; ///< Longest park between checks
+    std::atomic<bool> m_running;        ///< Flag cleared by stop()
+    std::atomic<uint64_t> m_drained;    ///< Buffers drained
+    std::thread m_thread;               ///< Drainer thread
+    SiteSketch* m_sketch;               ///< Sketch fed with drained records, or nullptr
+    std::chrono::nanoseconds m_stats_interval;       ///< Time between site stats records
+    std::chrono::steady_clock::time_point m_next_stats; ///< When the next site stats record is due
+    std::unique_ptr<uint8_t[]> m_stats_buffer;       ///< Holds the site stats record
+    std::size_t m_stats_buffer_size;                 ///< Capacity of m_stats_buffer
+    BlockSummarizer* m_summarizer;                   ///< Summarizer of drained buffers, or nullptr
+};
+
+/**
+ * @class FormatDrainer
+ * @brief Drains a pool through parallel formatter threads, writing their text in seal order.
+ *
+ * A dispatcher thread numbers sealed buffers in the order they were sealed
+ * and hands them to a pool of formatter threads. Each formatter turns a
+ * buffer into text in a reorder slot of its own, returns the buffer to the
+ * pool straight away, and then writes every slot that is next in order, so
+ * output order matches seal order no matter which formatter finishes first.
+ * At most slots() buffers are in flight between sealing and writing.
+ *
+ * Slot strings keep their capacity between uses, so steady-state formatting
+ * allocates nothing once they have grown.
+ *
+ * @example
+ * @code
+ * FormatDrainer drainer(pool, 4,
+ *     [](const uint8_t* data, std::size_t size, std::string& out) { format_text(data, size, out); },
+ *     [&](const char* text, std::size_t size) { ::write(fd, text, size); });
+ * drainer.start();
+ * @endcode
+ */
+class FormatDrainer {
+public:
+    /// Appends the text of one buffer to out; runs on a formatter thread.
+    using Formatter = std::function<void(const uint8_t* data, std::size_t size, std::string& out)>;
+
+    /// Receives formatted text in seal order; calls never overlap.
+    using Writer = std::function<void(const char* data, std::size_t size)>;
+
+    /**
+     * @brief Construct a drainer; call start() to run it.
+     *
+     * @param pool Pool to drain; must outlive the drainer.
+     * @param threads Number of formatter threads, at least 1.
+     * @param format Formats one buffer (e.g. with format_text()).
+     * @param write Consumes formatted text.
+     * @param timeout Longest time the dispatcher parks between checks.
+     */
+    FormatDrainer(BufferPool& pool, std::size_t threads, Formatter format, Writer write,
+                  std::chrono::nanoseconds timeout = std::chrono::milliseconds(100));
+
+    /**
+     * @brief Stop the threads (formatting and writing what is left) if still running.
+     */
+    ~FormatDrainer();
+
+    FormatDrainer(const FormatDrainer&) = delete;
+    FormatDrainer& operator=(const FormatDrainer&) = delete;
+
+    /**
+     * @brief Start the dispatcher and formatter threads.
+     */
+    void start();
+
+    /**
+     * @brief Format and write every sealed buffer, then join the threads.
+     */
+    void stop() noexcept;
+
+    /// Number of buffers written so far.
+    inline uint64_t written() const noexcept { return m_written.load(std::memory_order_relaxed); }
+
+    /// Number of reorder slots (buffers in flight between sealing and writing).
+    inline std::size_t slots() const noexcept { return m_slots.size(); }
+
+private:
+    /// One buffer's place in the output order.
+    struct Slot {
+        std::string text;   ///< Formatted text
+        bool ready = false; ///< Flag indicating text is complete and not yet written
+    };
+
+    /// A buffer waiting for a formatter.
+    struct Job {
+        DetachedBuffer buffer; ///< Sealed buffer
+        uint64_t ticket;       ///< Position in seal order
+    };
+
+    void dispatch() noexcept;
+    void format() noexcept;
+
+    /// Write consecutive ready slots; m_mutex must be held by lock.
+    void write_ready(std::unique_lock<std::mutex>& lock) noexcept;
+
+    BufferPool& m_pool;                 ///< Pool being drained
+    Formatter m_format;                 ///< Buffer-to-text function
+    Writer m_write;                     ///< Consumer of text
+    std::chrono::nanoseconds m_timeout; ///< Longest dispatcher park between checks
+    std::vector<Slot> m_slots;          ///< Reorder ring indexed by ticket % size
+    std::deque<Job> m_jobs;             ///< Buffers waiting for a formatter
+    std::mutex m_mutex;                 ///< Guards m_jobs, m_slots flags and the counters below
+    std::condition_variable m_job_ready;  ///< Signals formatters: job queued or stopping
+    std::condition_variable m_slot_free;  ///< Signals the dispatcher: a slot was written
+    uint64_t m_next_ticket;             ///< Ticket of the next sealed buffer
+    uint64_t m_next_write;              ///< Ticket of the next slot to write
+    bool m_writing;                     ///< Flag indicating a formatter is running m_write
+    bool m_stopping;                    ///< Flag telling formatters to exit once m_jobs is empty
+    std::atomic<bool> m_running;        ///< Flag cleared by stop()
+    std::atomic<uint64_t> m_written;    ///< Buffers written
+    std::size_t m_thread_count;         ///< Number of formatter threads
+    std::thread m_dispatcher;           ///< Dispatcher thread
+    std::vector<std::thread> m_formatters; ///< Formatter threads
+};
+
+} // namespace log_buffer
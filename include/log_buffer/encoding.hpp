@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+namespace log_buffer {
+
+/**
+ * @brief Maximum number of bytes a LEB128-encoded 64-bit value can occupy.
+ */
+inline constexpr std::size_t kMaxVarintSize = 10;
+
+/**
+ * @brief Get the number of bytes needed to encode a value as an unsigned LEB128 varint.
+ *
+ * @param value The value to encode.
+ * @return Encoded size in bytes (1 to kMaxVarintSize).
+ */
+inline constexpr std::size_t varint_size(uint64_t value) noexcept {
+    std::size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+/**
+ * @brief Encode a value as an unsigned LEB128 varint.
+ *
+ * @param out Destination, must have at least varint_size(value) bytes available.
+ * @param value The value to encode.
+ * @return Pointer one past the last byte written.
+ */
+inline uint8_t* encode_varint(uint8_t* out, uint64_t value) noexcept {
+    while (value >= 0x80) {
+        *out++ = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+/**
+ * @brief Encode a value as an unsigned LEB128 varint of a fixed width.
+ *
+ * Uses redundant continuation bytes so the encoding occupies exactly width
+ * bytes. This lets a writer reserve the prefix before the final length is
+ * known. decode_varint() reads padded and minimal encodings alike.
+ *
+ * @param out Destination, must have at least width bytes available.
+ * @param value The value to encode.
+ * @param width Encoded size, must be at least varint_size(value).
+ * @return Pointer one past the last byte written.
+ */
+inline uint8_t* encode_varint_padded(uint8_t* out, uint64_t value, std::size_t width) noexcept {
+    for (std::size_t i = 1; i < width; ++i) {
+        *out++ = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+/**
+ * @brief Decode an unsigned LEB128 varint.
+ *
+ * @param p Pointer to the first byte of the varint.
+ * @param end Pointer one past the last readable byte.
+ * @param value Receives the decoded value.
+ * @return Pointer one past the varint, or nullptr if it is truncated or malformed.
+ */
+inline const uint8_t* decode_varint(const uint8_t* p, const uint8_t* end, uint64_t& value) noexcept {
+    value = 0;
+    for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        const uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Decode a length-prefixed string field (see StringFormat::LengthPrefixed).
+ *
+ * The field is a varint byte count followed by that many raw bytes, so the
+ * payload may contain arbitrary data including embedded NULs.
+ *
+ * @param p Pointer to the start of the field.
+ * @param end Pointer one past the last readable byte.
+ * @param out Receives a view over the string bytes (no copy is made).
+ * @return Pointer to the next field, or nullptr if the field is truncated.
+ */
+inline const uint8_t* decode_string(const uint8_t* p, const uint8_t* end, std::string_view& out) noexcept {
+    uint64_t length = 0;
+    p = decode_varint(p, end, length);
+    if (p == nullptr || length > static_cast<uint64_t>(end - p)) {
+        return nullptr;
+    }
+    out = std::string_view(reinterpret_cast<const char*>(p), static_cast<std::size_t>(length));
+    return p + length;
+}
+
+} // namespace log_buffer
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+#include "log_buffer/record.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define LOG_BUFFER_HAVE_RDTSC 1
+#endif
+
+namespace log_buffer {
+
+/**
+ * @brief Read a cheap, monotonic cycle counter.
+ *
+ * The TSC on x86 (a few cycles, not serializing), steady_clock nanoseconds
+ * elsewhere. Only differences between two reads on one thread are meaningful.
+ */
+inline uint64_t read_cycles() noexcept {
+#ifdef LOG_BUFFER_HAVE_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ * @struct GovernorConfig
+ * @brief Budget and reaction settings of a Governor.
+ */
+struct GovernorConfig {
+    double budget = 0.02;                        ///< Largest fraction of time to spend logging
+    double relax_below = 0.5;                    ///< Step back down when load < budget * relax_below
+    std::chrono::nanoseconds interval = std::chrono::milliseconds(10); ///< Measurement interval (at least 1ns)
+    uint32_t sample_every = 64;                  ///< Time one admitted call in this many (power of two)
+    uint32_t max_sampling_shift = 10;            ///< Most aggressive sampling: keep 1 in 2^shift
+    Level protected_level = Level::Warn;         ///< This level and above are never shed
+};
+
+/**
+ * @class Governor
+ * @brief Keeps the time a thread spends logging under a budget by shedding low-priority records.
+ *
+ * Call sites ask admit() before building a record and wrap the write in a
+ * Scope. One admitted call in sample_every is timed with read_cycles(); the
+ * sampled cycles, scaled up, estimate the fraction of each interval spent in
+ * Logger writes. When an interval's load exceeds the budget the governor
+ * escalates one step, and when it falls below budget * relax_below it steps
+ * back. The steps, mildest first:
+ * 1. Sample records below protected_level: keep 1 in 2, then 1 in 4, ... up
+ *    to 1 in 2^max_sampling_shift.
+ * 2. Then raise the level floor one level at a time up to protected_level,
+ *    dropping everything below it.
+ * Records at protected_level and above are always admitted.
+ *
+ * @code
+ * if (governor.admit(Level::Debug)) {
+ *     Governor::Scope timed(governor);
+ *     logger.begin_record(Level::Debug, kNetTag);
+ *     logger << "packet " << id;
+ *     logger.end_record();
+ * }
+ * @endcode
+ *
+ * The unsampled cost of admit() plus Scope is a compare, a counter increment
+ * and a branch; sampled calls add two counter reads and a clock read. One
+ * shed call in sample_every also reads the clock, so a thread whose calls
+ * are all being shed still closes intervals and relaxes.
+ *
+ * @note Thread Safety: not thread-safe; use one governor per producer thread,
+ *       as with Logger.
+ */
+class Governor {
+public:
+    /**
+     * @brief Times one admitted write if it is a sampled call.
+     */
+    class Scope {
+    public:
+        inline explicit Scope(Governor& governor) noexcept : m_governor(governor), m_start(governor.begin()) {}
+        inline ~Scope() { m_governor.end(m_start); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Governor& m_governor;  ///< Governor being fed
+        uint64_t m_start;      ///< read_cycles() at the start, or 0 if not sampled
+    };
+
+    /**
+     * @brief Construct a governor admitting everything.
+     *
+     * @param config Budget and reaction settings.
+     */
+    explicit Governor(const GovernorConfig& config = GovernorConfig()) noexcept;
+
+    /**
+     * @brief Decide whether a record of this level should be written.
+     *
+     * @param level Severity of the record.
+     * @return false if the record is shed (counted in shed()).
+     */
+    inline bool admit(Level level) noexcept {
+        if (level >= m_config.protected_level) {
+            return true;
+        }
+        if (level < m_floor || (++m_sample_counter & m_sample_mask) != 0) {
+            // Shed calls run no Scope, so they also check for the end of the interval
+            if ((++m_shed & m_timing_mask) == 0) {
+                sample_taken();
+            }
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Start timing an admitted write (use Scope instead).
+     *
+     * @return Start stamp, or 0 if this call is not sampled.
+     */
+    inline uint64_t begin() noexcept {
+        return (++m_calls & m_timing_mask) == 0 ? read_cycles() : 0;
+    }
+
+    /**
+     * @brief Finish timing an admitted write (use Scope instead).
+     *
+     * @param start Value returned by begin().
+     */
+    inline void end(uint64_t start) noexcept {
+        if (start != 0) {
+            m_sampled_cycles += read_cycles() - start;
+            sample_taken();
+        }
+    }
+
+    /**
+     * @brief Apply one interval's measured load and adjust the shedding step.
+     *
+     * Called by end() at each interval boundary; callable directly to feed
+     * an externally measured load.
+     *
+     * @param load Fraction of the interval spent logging.
+     */
+    void update(double load) noexcept;
+
+    /// Load measured over the last completed interval.
+    inline double load() const noexcept { return m_load; }
+
+    /// Current sampling of records below protected_level: 1 in 2^sampling_shift().
+    inline uint32_t sampling_shift() const noexcept { return m_sampling_shift; }
+
+    /// Least severe level currently admitted (below protected_level sampling applies too).
+    inline Level floor() const noexcept { return m_floor; }
+
+    /// Records rejected by admit() so far.
+    inline uint64_t shed() const noexcept { return m_shed; }
+
+    /// The settings in use.
+    inline const GovernorConfig& config() const noexcept { return m_config; }
+
+private:
+    /// Slow path of end() and of shed calls: close the interval if it is over.
+    void sample_taken() noexcept;
+
+    /// Recompute m_sample_mask from m_sampling_shift.
+    inline void apply_sampling() noexcept { m_sample_mask = (uint64_t{1} << m_sampling_shift) - 1; }
+
+    GovernorConfig m_config;     ///< Settings
+    uint64_t m_timing_mask;      ///< sample_every - 1 (also spaces interval checks on shed calls)
+    uint64_t m_calls;            ///< Admitted calls seen by begin()
+    uint64_t m_sample_counter;   ///< Low-priority calls seen by admit()
+    uint64_t m_sample_mask;      ///< Admit a low-priority call when counter & mask == 0
+    uint32_t m_sampling_shift;   ///< log2 of the current sampling ratio
+    Level m_floor;               ///< Least severe admitted level
+    uint64_t m_shed;             ///< Records rejected by admit()
+    uint64_t m_sampled_cycles;   ///< Cycles in sampled calls this interval
+    uint64_t m_interval_start;   ///< read_cycles() at the start of this interval
+    std::chrono::steady_clock::time_point m_interval_end; ///< When this interval ends
+    double m_load;               ///< Load of the last completed interval
+};
+
+} // namespace log_buffer
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+#include "log_buffer/record.hpp"
+
+namespace log_buffer {
+
+/**
+ * @brief Number of tags covered by a LevelTable (every uint16_t tag value).
+ */
+inline constexpr std::size_t kLevelTableTags = 65536;
+
+/**
+ * @brief Level mask enabling one level and everything more severe.
+ *
+ * @param min_level The least severe level to enable.
+ * @return Bitmap with bit n set for each enabled Level n.
+ */
+inline constexpr uint8_t levels_from(Level min_level) noexcept {
+    return static_cast<uint8_t>(((1u << kLevelCount) - 1) & ~((1u << static_cast<unsigned>(min_level)) - 1));
+}
+
+/**
+ * @brief Default per-tag mask of a new table: Info and above.
+ */
+inline constexpr uint8_t kDefaultLevelMask = levels_from(Level::Info);
+
+/**
+ * @struct LevelControlBlock
+ * @brief Layout of the level table, shared between processes when named.
+ *
+ * One byte per tag holds a bitmap of enabled levels, so a check is a single
+ * relaxed load. Writers (e.g. the log_levels tool) store whole bytes, and
+ * readers see changes within a few cache-line transfers.
+ */
+struct LevelControlBlock {
+    std::atomic<uint32_t> magic;                        ///< kLevelTableMagic once initialized (release-stored)
+    uint32_t version;                                   ///< kLevelTableVersion
+    std::atomic<uint8_t> levels[kLevelTableTags];       ///< Enabled-level bitmap per tag
+};
+
+inline constexpr uint32_t kLevelTableMagic = 0x4C564C54;  ///< "LVLT"
+inline constexpr uint32_t kLevelTableVersion = 1;
+
+/**
+ * @brief How long LevelTable::open() waits for a table another process is still creating.
+ */
+inline constexpr std::chrono::milliseconds kLevelTableAttachTimeout{1000};
+
+/**
+ * @class LevelTable
+ * @brief Runtime per-tag level filter, optionally shared through POSIX shared memory.
+ *
+ * Call sites check the table before formatting anything, so disabled sites
+ * cost one relaxed load and a branch:
+ * @code
+ * if (levels.enabled(kNetTag, Level::Debug)) {
+ *     logger.begin_record(Level::Debug, kNetTag);
+ *     logger << "packet " << id;
+ *     logger.end_record();
+ * }
+ * @endcode
+ * A named table (open()) can be changed from outside the process with the
+ * log_levels tool, e.g. to enable debug logging for one tag in production.
+ *
+ * @note Thread Safety: enabled() and the setters may be called concurrently
+ *       from any thread or process; open() and close() may not.
+ */
+class LevelTable {
+public:
+    /**
+     * @brief Construct a table with no storage; call open() or open_local().
+     */
+    inline LevelTable() noexcept : m_block(nullptr), m_shared(false) {}
+
+    ~LevelTable();
+
+    LevelTable(LevelTable&& other) noexcept;
+    LevelTable& operator=(LevelTable&& other) noexcept;
+    LevelTable(const LevelTable&) = delete;
+    LevelTable& operator=(const LevelTable&) = delete;
+
+    /**
+     * @brief Attach to a named shared-memory table.
+     *
+     * @param name POSIX shared-memory name, e.g. "/myapp.levels".
+     * @param create If true, create the table (with kDefaultLevelMask for every
+     *               tag) when it does not exist yet.
+     * @return true on success, false if the table could not be created or
+     *         mapped, or holds an incompatible layout.
+     *
+     * If another process is still creating the table, this waits up to
+     * kLevelTableAttachTimeout for it to be sized and initialized.
+     */
+    bool open(const char* name, bool create) noexcept;
+
+    /**
+     * @brief Create a private, process-local table with kDefaultLevelMask for every tag.
+     *
+     * @return true on success, false if memory could not be allocated.
+     */
+    bool open_local() noexcept;
+
+    /**
+     * @brief Release the table's storage. Named tables stay in shared memory.
+     */
+    void close() noexcept;
+
+    /**
+     * @brief Delete a named table from shared memory.
+     *
+     * @param name POSIX shared-memory name.
+     * @return true if the name was removed.
+     */
+    static bool remove(const char* name) noexcept;
+
+    /**
+     * @brief Check whether the table is usable.
+     *
+     * @return true after a successful open() or open_local().
+     */
+    inline bool is_open() const noexcept { return m_block != nullptr; }
+
+    /**
+     * @brief Check whether a level is enabled for a tag.
+     *
+     * @param tag The record tag.
+     * @param level The level to test.
+     * @return true if records of this tag and level should be logged.
+     */
+    inline bool enabled(uint16_t tag, Level level) const noexcept {
+        return (m_block->levels[tag].load(std::memory_order_relaxed) >> static_cast<unsigned>(level)) & 1u;
+    }
+
+    /**
+     * @brief Get the enabled-level bitmap of a tag.
+     *
+     * @param tag The record tag.
+     * @return Bitmap with bit n set for each enabled Level n.
+     */
+    inline uint8_t levels(uint16_t tag) const noexcept {
+        return m_block->levels[tag].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Set the enabled-level bitmap of a tag.
+     *
+     * @param tag The record tag.
+     * @param mask Bitmap with bit n set for each enabled Level n.
+     */
+    inline void set_levels(uint16_t tag, uint8_t mask) noexcept {
+        m_block->levels[tag].store(mask, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Enable a level and everything more severe for a tag.
+     *
+     * @param tag The record tag.
+     * @param min_level The least severe level to enable.
+     */
+    inline void set_min_level(uint16_t tag, Level min_level) noexcept {
+        set_levels(tag, levels_from(min_level));
+    }
+
+    /**
+     * @brief Set the enabled-level bitmap of every tag.
+     *
+     * @param mask Bitmap with bit n set for each enabled Level n.
+     */
+    void set_all(uint8_t mask) noexcept;
+
+private:
+    LevelControlBlock* m_block;  ///< Mapped or allocated table, or nullptr
+    bool m_shared;               ///< Flag indicating m_block is a shared-memory mapping
+};
+
+} // namespace log_buffer
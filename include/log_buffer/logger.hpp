@@ -7,6 +7,10 @@
 #include <charconv>
 #include <type_traits>
 #include <ios>
+#include <limits>
+
+#include "log_buffer/encoding.hpp"
+#include "log_buffer/record.hpp"
 
 namespace log_buffer {
 
@@ -21,6 +25,38 @@ enum class IntFormat {
     Oct   ///< Octal format (base 8)
 };
 
+/**
+ * @enum StringFormat
+ * @brief Encoding used for string and formatted integer fields.
+ */
+enum class StringFormat {
+    NulTerminated,  ///< Bytes followed by '\0' (default, readable with strlen)
+    LengthPrefixed  ///< Varint byte count followed by the bytes, safe for embedded NULs
+};
+
+/**
+ * @brief Field length limit meaning "no limit" (the default).
+ */
+inline constexpr std::size_t kNoFieldLimit = std::numeric_limits<std::size_t>::max();
+
+/**
+ * @brief Value for Logger::set_watermarks() that disables the high watermark.
+ */
+inline constexpr std::size_t kNoWatermark = std::numeric_limits<std::size_t>::max();
+
+/**
+ * @brief Marker appended to string fields that were cut to the maximum field length.
+ */
+inline constexpr std::string_view kTruncationMarker = "...";
+
+/**
+ * @brief Size above which append_range() copies with non-temporal stores.
+ *
+ * Ranges this large would evict most of the cache when copied normally, and
+ * the destination is usually not read again by the writing thread.
+ */
+inline constexpr std::size_t kStreamingCopyThreshold = 256 * 1024;
+
 /**
  * @struct BinaryData
  * @brief Helper struct for logging binary data with convenient brace initialization.
@@ -36,6 +72,29 @@ struct BinaryData {
     std::size_t size;     ///< Size of data in bytes
 };
 
+class Notifier;
+class Logger;
+class SiteSketch;
+
+/**
+ * @brief Callback for Logger watermark crossings.
+ *
+ * @param logger The logger whose fill level crossed a watermark.
+ * @param high true when rising past the high watermark, false when back below the low one.
+ * @param context The pointer given to Logger::set_watermarks().
+ */
+using WatermarkHook = void (*)(Logger& logger, bool high, void* context);
+
+/**
+ * @struct DetachedBuffer
+ * @brief A buffer released from a Logger by Logger::detach().
+ */
+struct DetachedBuffer {
+    uint8_t* data;          ///< Pointer to the buffer (nullptr if none was attached)
+    std::size_t size;       ///< Number of bytes written
+    std::size_t capacity;   ///< Total capacity of the buffer in bytes
+};
+
 /**
  * @class Logger
  * @brief A header-only logging library that writes to a user-provided buffer.
@@ -49,6 +108,10 @@ struct BinaryData {
  * 
  * @note Memory: No dynamic allocation - all data written to user-provided buffer.
  * 
+ * @note Ownership: A Logger is move-only, so two instances never write to the
+ *       same buffer. Use detach()/attach() to hand a filled buffer to another
+ *       thread and continue with a fresh one.
+ * 
  * @example
  * @code
  * uint8_t buffer[256];
@@ -71,7 +134,105 @@ public:
      * @note The buffer is not initialized or cleared by the constructor.
      */
     inline Logger(uint8_t* buffer, std::size_t size) noexcept
-        : m_buffer(buffer), m_capacity(size), m_position(0), m_overflow(false), m_int_format(IntFormat::Dec) {}
+        : m_buffer(buffer), m_capacity(size), m_position(0), m_overflow(false), m_int_format(IntFormat::Dec),
+          m_string_format(StringFormat::NulTerminated), m_max_field_length(kNoFieldLimit),
+          m_record_start(kNoRecord), m_record_failed(false), m_parent(nullptr), m_gap_records(false),
+          m_dropped_records(0), m_dropped_bytes(0), m_sequence_numbers(false), m_have_sequence_base(false),
+          m_next_sequence(0), m_last_sequence(0), m_buffer_header(false), m_header_size(0), m_epoch(0),
+          m_format_hash(0), m_record_metadata(false), m_epoch_ns(0), m_notifier(nullptr),
+          m_notify_threshold(kNoSignal), m_notify_armed(false), m_high_watermark(kNoWatermark), m_low_watermark(0),
+          m_watermark_hook(nullptr), m_watermark_context(nullptr), m_above_high(false),
+          m_signal_position(kNoSignal), m_drop_sketch(nullptr), m_record_key(0) {}
+
+    /**
+     * @brief Move-construct a logger, taking over the other logger's buffer and settings.
+     * 
+     * @param other The logger to move from. It is left with no buffer, so any
+     *              write to it fails with overflow until attach() is called.
+     */
+    Logger(Logger&& other) noexcept;
+
+    /**
+     * @brief Move-assign a logger, taking over the other logger's buffer and settings.
+     * 
+     * @param other The logger to move from. It is left with no buffer.
+     * @return Reference to this Logger.
+     */
+    Logger& operator=(Logger&& other) noexcept;
+
+    Logger(const Logger&) = delete;             ///< Copying would alias the buffer
+    Logger& operator=(const Logger&) = delete;  ///< Copying would alias the buffer
+
+    /**
+     * @brief Exchange buffers, write state and settings with another logger.
+     * 
+     * @param other The logger to swap with.
+     */
+    void swap(Logger& other) noexcept;
+
+    /**
+     * @brief Release the buffer and its contents to the caller.
+     * 
+     * Any open record is discarded first and counted as dropped, so the
+     * detached bytes hold only complete records and the next buffer's gap
+     * record reports it. The logger is left with no buffer until attach().
+     * Format settings are kept.
+     * 
+     * @return The buffer pointer, bytes written and capacity.
+     */
+    DetachedBuffer detach() noexcept;
+
+    /**
+     * @brief Start writing to a new buffer.
+     * 
+     * Replaces the current buffer (without touching its contents), clears the
+     * overflow flag and starts writing at offset 0. Format settings are kept.
+     * 
+     * @param buffer Pointer to the buffer to write to.
+     * @param size Size of the buffer in bytes.
+     */
+    void attach(uint8_t* buffer, std::size_t size) noexcept;
+
+    /**
+     * @brief Carve a sub-logger out of this logger's buffer.
+     * 
+     * Reserves n bytes (rounded up to kRecordAlignment, starting at the next
+     * record boundary) and returns a Logger that writes into exactly that
+     * region, with this logger's format settings. Several children can be
+     * filled concurrently by different threads, since their regions never
+     * overlap, and the final buffer needs no second copy to assemble.
+     * 
+     * @param n Number of bytes to reserve.
+     * @return The child logger. If the reservation does not fit, or this
+     *         logger has an open record, this logger's overflow flag is set
+     *         and the child has no capacity.
+     * 
+     * @note The parent must outlive its children and must not be moved, reset
+     *       or detached while they are open.
+     * @note child() and close() update the parent without synchronization:
+     *       calls on the same parent must be serialized with each other and
+     *       with other writes to the parent (e.g. under one mutex). Only
+     *       writes through the children themselves can run concurrently.
+     * @see close()
+     */
+    Logger child(std::size_t n) noexcept;
+
+    /**
+     * @brief Close a child logger, returning or filling its unused space.
+     * 
+     * If nothing was reserved in the parent after this child, the unused tail
+     * is given back to the parent. Otherwise it is zero-filled so it reads as
+     * padding. Any open record in the child is discarded first. The child is
+     * left with no buffer.
+     * 
+     * @return true if this was an open child logger, false otherwise.
+     * 
+     * @note Closing touches the parent, so it must not race with other writes
+     *       to the parent, with child() or with closing sibling children
+     *       (e.g. close all children after joining the threads that filled
+     *       them, or hold the mutex that serializes child()).
+     */
+    bool close() noexcept;
 
     /**
      * @brief Get the number of bytes written to the buffer.
@@ -99,15 +260,232 @@ public:
      */
     inline bool has_overflowed() const noexcept { return m_overflow; }
 
+    /**
+     * @brief Get the number of writes rejected since the last gap record.
+     * 
+     * A rejected write outside a record counts as one record; a framed record
+     * discarded by end_record() counts once however many of its writes failed.
+     * 
+     * @return Dropped records not yet reported in a gap record.
+     */
+    inline uint64_t dropped_records() const noexcept { return m_dropped_records; }
+
+    /**
+     * @brief Get the number of bytes rejected since the last gap record.
+     * 
+     * @return Dropped bytes not yet reported in a gap record.
+     */
+    inline uint64_t dropped_bytes() const noexcept { return m_dropped_bytes; }
+
     /**
      * @brief Reset the logger to start writing from the beginning of the buffer.
      * 
-     * Clears the overflow flag and resets the write position to 0.
-     * Does not clear the buffer contents.
+     * Clears the overflow flag, discards any open record and resets the write
+     * position to 0. Does not clear the buffer contents. If gap records are
+     * enabled and writes were dropped, a RecordType::Gap record carrying the
+     * dropped counts is written first.
+     */
+    void reset() noexcept;
+
+    /**
+     * @brief Enable or disable gap records for dropped writes.
+     * 
+     * When enabled, the counts reported by dropped_records() and dropped_bytes()
+     * are written into the stream as a RecordType::Gap record at the next
+     * reset() or attach(), where there is room again, and then cleared.
+     * Readers learn how much was lost and where. Counting happens only
+     * on the overflow path, so successful writes cost nothing extra.
+     * 
+     * @param enable true to write gap records (default false).
+     * @return Reference to this Logger for chaining.
+     */
+    inline Logger& set_gap_records(bool enable) noexcept {
+        m_gap_records = enable;
+        return *this;
+    }
+
+    /**
+     * @brief Enable or disable per-record sequence numbers.
+     * 
+     * When enabled, every begin_record() takes the next number from a
+     * per-logger counter, including records that end up dropped. The number is
+     * stored after the record header as a varint delta from the previous
+     * record in the buffer, which is one byte in the common case. The first
+     * record after reset(), attach(), append() or child() stores the full
+     * value instead. RecordReader restores the absolute numbers and reports
+     * skipped ones as RecordView::sequence_gap.
+     * 
+     * @param enable true to number records (default false).
+     * @return Reference to this Logger for chaining.
+     */
+    inline Logger& set_sequence_numbers(bool enable) noexcept {
+        m_sequence_numbers = enable;
+        return *this;
+    }
+
+    /**
+     * @brief Check whether sequence numbers are enabled.
+     * 
+     * @return true if records carry sequence numbers.
+     */
+    inline bool get_sequence_numbers() const noexcept {
+        return m_sequence_numbers;
+    }
+
+    /**
+     * @brief Get the sequence number the next record will get.
+     * 
+     * @return Number of records begun since construction (or set_next_sequence()).
+     */
+    inline uint64_t next_sequence() const noexcept {
+        return m_next_sequence;
+    }
+
+    /**
+     * @brief Set the sequence number the next record will get.
+     * 
+     * Useful to continue a producer's numbering in a new Logger.
+     * 
+     * @param sequence The next sequence number.
+     * @return Reference to this Logger for chaining.
+     */
+    inline Logger& set_next_sequence(uint64_t sequence) noexcept {
+        m_next_sequence = sequence;
+        m_have_sequence_base = false;
+        return *this;
+    }
+
+    /**
+     * @brief Enable or disable the buffer header.
+     * 
+     * When enabled, a BufferHeader (pid, tid, thread name, clock calibration,
+     * format hash, first sequence number) is written at offset 0 on every
+     * reset() and attach(), and right away if nothing has been written yet.
+     * This makes any dumped buffer self-describing. Records read with
+     * RecordReader skip it automatically. If the buffer is too small for the
+     * header, the header is left out.
+     * 
+     * @param enable true to write buffer headers (default false).
+     * @return Reference to this Logger for chaining.
+     */
+    Logger& set_buffer_header(bool enable) noexcept;
+
+    /**
+     * @brief Check whether buffer headers are enabled.
+     * 
+     * @return true if a BufferHeader starts every buffer epoch.
+     */
+    inline bool get_buffer_header() const noexcept {
+        return m_buffer_header;
+    }
+
+    /**
+     * @brief Set the format table hash stored in subsequent buffer headers.
+     * 
+     * @param hash Hash identifying the format strings/schema the records use.
+     * @return Reference to this Logger for chaining.
+     */
+    inline Logger& set_format_hash(uint64_t hash) noexcept {
+        m_format_hash = hash;
+        return *this;
+    }
+
+    /**
+     * @brief Enable or disable per-record metadata (site and timestamp).
+     * 
+     * When enabled, every framed record carries a RecordMetadata block right
+     * after its header: the site passed to begin_record() and the time since
+     * the buffer epoch in microseconds. The epoch is the BufferHeader's
+     * steady_ns when buffer headers are on, otherwise the last reset() or
+     * the moment metadata was enabled.
+     * 
+     * @param enable true to write record metadata (default false).
+     * @return Reference to this Logger for chaining.
+     */
+    Logger& set_record_metadata(bool enable) noexcept;
+
+    /**
+     * @brief Check whether per-record metadata is enabled.
+     * 
+     * @return true if records carry a RecordMetadata block.
+     */
+    inline bool get_record_metadata() const noexcept {
+        return m_record_metadata;
+    }
+
+    /**
+     * @brief Signal a Notifier when the buffer fills past a threshold.
+     * 
+     * The first write that takes bytes_written() to threshold or beyond calls
+     * notifier->notify(), once per buffer epoch; reset() and attach() re-arm
+     * it. This lets a drainer (see drain.hpp) get ready before the buffer is
+     * sealed without producers signalling on every write. The check is one
+     * compare against a precomputed position. If the buffer is already at
+     * or past threshold, the notifier is signalled immediately.
+     * 
+     * @param notifier Notifier to signal, or nullptr to disable.
+     * @param threshold Fill level in bytes that triggers the signal.
+     * @return Reference to this Logger for chaining.
+     */
+    Logger& set_notifier(Notifier* notifier, std::size_t threshold) noexcept;
+
+    /**
+     * @brief Set high/low watermarks for backpressure.
+     * 
+     * When a write takes bytes_written() to high or beyond,
+     * above_high_watermark() becomes true and hook(logger, true, context) is
+     * called, once. When the fill level later drops below low (reset(),
+     * attach(), a dropped record or a closed child), the flag clears and
+     * hook(logger, false, context) is called. Upstream code can use this to
+     * shed or sample logging before writes start to overflow. Like
+     * set_notifier(), the check is one compare per write.
+     * 
+     * The hook runs after the write that crossed the mark has completed. It
+     * may inspect the logger and change settings, but must not reset or
+     * detach it while a record is open.
+     * 
+     * @param high Fill level in bytes that raises the flag, or kNoWatermark to disable.
+     * @param low Fill level below which the flag clears (clamped to high).
+     * @param hook Function to call on each crossing, or nullptr for the flag only.
+     * @param context Passed to hook.
+     * @return Reference to this Logger for chaining.
+     */
+    Logger& set_watermarks(std::size_t high, std::size_t low, WatermarkHook hook = nullptr,
+                           void* context = nullptr) noexcept;
+
+    /**
+     * @brief Check whether the buffer is above the high watermark.
+     * 
+     * @return true between crossing the high watermark and dropping below the low one.
+     */
+    inline bool above_high_watermark() const noexcept {
+        return m_above_high;
+    }
+
+    /**
+     * @brief Count dropped records per call site.
+     * 
+     * Each record that end_record() drops is added to the sketch with weight
+     * 1, keyed by its site (with record metadata enabled) or its tag, so the
+     * sites responsible for overflow can be reported with SiteSketch::emit().
+     * Only the drop path touches the sketch.
+     * 
+     * @param sketch Sketch to feed, or nullptr to disable. Must outlive its use
+     *               here and must not be shared with another thread.
+     * @return Reference to this Logger for chaining.
+     */
+    inline Logger& set_drop_sketch(SiteSketch* sketch) noexcept {
+        m_drop_sketch = sketch;
+        return *this;
+    }
+
+    /**
+     * @brief Check whether gap records are enabled.
+     * 
+     * @return true if gap records are written on reset() and attach().
      */
-    inline void reset() noexcept {
-        m_position = 0;
-        m_overflow = false;
+    inline bool get_gap_records() const noexcept {
+        return m_gap_records;
     }
 
     /**
@@ -130,6 +508,85 @@ public:
         return m_int_format;
     }
 
+    /**
+     * @brief Set the encoding for subsequent string and integer fields.
+     * 
+     * NulTerminated output stays compatible with strlen-based readers but cannot
+     * represent strings containing '\0'. LengthPrefixed output stores a varint
+     * length before the bytes, so any byte sequence round-trips and readers can
+     * skip fields without scanning (see decode_string()).
+     * 
+     * @param format The format to use (NulTerminated, LengthPrefixed).
+     * @return Reference to this Logger for chaining.
+     */
+    inline Logger& set_string_format(StringFormat format) noexcept {
+        m_string_format = format;
+        return *this;
+    }
+
+    /**
+     * @brief Get the current string format.
+     * 
+     * @return The current string format setting.
+     */
+    inline StringFormat get_string_format() const noexcept {
+        return m_string_format;
+    }
+
+    /**
+     * @brief Set the maximum number of string bytes copied per field.
+     * 
+     * Longer strings are cut to max_len bytes followed by kTruncationMarker, so a
+     * single oversized field costs a bounded amount of buffer space instead of
+     * failing the write. Integers and binary data are not affected.
+     * 
+     * @param max_len Maximum string bytes per field, or kNoFieldLimit (default).
+     * @return Reference to this Logger for chaining.
+     */
+    inline Logger& set_max_field_length(std::size_t max_len) noexcept {
+        m_max_field_length = max_len;
+        return *this;
+    }
+
+    /**
+     * @brief Get the maximum field length.
+     * 
+     * @return The current maximum field length, or kNoFieldLimit.
+     */
+    inline std::size_t get_max_field_length() const noexcept {
+        return m_max_field_length;
+    }
+
+    /**
+     * @brief Start a framed record.
+     * 
+     * Writes a RecordHeader at the next kRecordAlignment boundary (zero-filling
+     * the gap). Fields logged until end_record() form the record's payload.
+     * Buffers written entirely as records can be walked and filtered with
+     * RecordReader and gather_records() without parsing the payloads.
+     * 
+     * @param level Severity of the record.
+     * @param tag User-defined module/component tag.
+     * @param site Call-site/format ID, stored only with set_record_metadata().
+     * @return true if the header was written, false if a record is already open
+     *         or buffer overflow would occur.
+     * 
+     * @note Always pair with end_record(), even if this returns false.
+     */
+    bool begin_record(Level level, uint16_t tag = 0, uint32_t site = 0) noexcept;
+
+    /**
+     * @brief Finish the record started by begin_record().
+     * 
+     * Patches the record size into the header and pads the buffer to the next
+     * record boundary. If any write inside the record overflowed, the whole
+     * record is discarded so the buffer never holds a partial record.
+     * 
+     * @return true if the record was committed, false if it was discarded or
+     *         no record was open.
+     */
+    bool end_record() noexcept;
+
     /**
      * @brief Log a raw C buffer (binary data).
      * 
@@ -141,29 +598,79 @@ public:
      */
     bool log(const uint8_t* data, std::size_t size) noexcept;
 
+    /**
+     * @brief Append another logger's contents in one bulk copy.
+     * 
+     * Copies everything the other logger has written, excluding its buffer
+     * header and an open record, so record framing and record headers are
+     * kept byte for byte. Records
+     * stay aligned as long as this logger is at a record boundary, which is
+     * always the case after end_record().
+     * 
+     * If the other logger writes record metadata and has a different epoch
+     * (set_record_metadata(), set_buffer_header(), reset()), the copied
+     * timestamps are shifted to this logger's epoch, saturating at 0 and
+     * kTimestampSaturated, so they still give the right wall-clock time.
+     * 
+     * @param other The logger whose contents to copy. Must not be this logger.
+     * @return true if successful, false if buffer overflow would occur.
+     */
+    bool append(const Logger& other) noexcept;
+
+    /**
+     * @brief Append a contiguous range of previously logged bytes.
+     * 
+     * Performs a single capacity check and a single copy. Ranges of at least
+     * kStreamingCopyThreshold bytes use non-temporal stores where available.
+     * The bytes are copied verbatim: record timestamps are not rebased (see
+     * append()).
+     * 
+     * @param begin Pointer to the first byte to copy.
+     * @param end Pointer one past the last byte to copy.
+     * @return true if successful, false if buffer overflow would occur.
+     */
+    bool append_range(const uint8_t* begin, const uint8_t* end) noexcept;
+
     /**
      * @brief Log a std::string_view with null terminator.
      * 
-     * Writes the string contents followed by a null terminator ('\0').
+     * Writes the string contents followed by a null terminator ('\0'), or a
+     * varint length followed by the contents in StringFormat::LengthPrefixed mode.
      * 
      * @param str The string view to log.
      * @return true if successful, false if buffer overflow would occur.
      * 
-     * @note Requires str.size() + 1 bytes of available capacity.
+     * @note Requires str.size() + 1 bytes of available capacity, or
+     *       varint_size(str.size()) + str.size() bytes when length-prefixed.
+     * @note Strings longer than get_max_field_length() are truncated as by
+     *       log(str, max_len).
      */
     bool log(std::string_view str) noexcept;
 
+    /**
+     * @brief Log at most max_len bytes of a string.
+     * 
+     * If str is longer than max_len, only its first max_len bytes are copied,
+     * followed by kTruncationMarker. The field is then encoded in the current
+     * string format like any other string.
+     * 
+     * @param str The string view to log.
+     * @param max_len Maximum number of bytes of str to copy.
+     * @return true if successful, false if buffer overflow would occur.
+     */
+    bool log(std::string_view str, std::size_t max_len) noexcept;
+
     /**
      * @brief Log a C string (const char*) with null terminator.
      * 
      * Writes the null-terminated C string followed by a null terminator.
+     * When a maximum field length is set, at most that many bytes (plus one) are
+     * scanned for the terminator.
      * 
      * @param str The null-terminated C string to log.
      * @return true if successful, false if buffer overflow would occur.
      */
-    inline bool log(const char* str) noexcept {
-        return log(std::string_view(str));
-    }
+    bool log(const char* str) noexcept;
 
     /**
      * @brief Log a std::string with null terminator.
@@ -177,6 +684,50 @@ public:
         return log(std::string_view(str));
     }
 
+    /**
+     * @brief Log a UTF-16 string, transcoded to UTF-8.
+     * 
+     * The UTF-8 output is written straight into the buffer and encoded in the
+     * current string format, with no temporary allocation. Capacity is checked
+     * against the worst case (3 bytes per code unit) first. The exact length is
+     * computed only when that bound does not fit. Unpaired surrogates are
+     * replaced with U+FFFD.
+     * 
+     * @param str The UTF-16 string to log.
+     * @return true if successful, false if buffer overflow would occur.
+     * 
+     * @note The maximum field length is not applied to transcoded strings.
+     */
+    bool log(std::u16string_view str) noexcept;
+
+    /**
+     * @brief Log a UTF-32 string, transcoded to UTF-8.
+     * 
+     * Same as the UTF-16 overload with a worst case of 4 bytes per code unit.
+     * Surrogates and values above U+10FFFF are replaced with U+FFFD.
+     * 
+     * @param str The UTF-32 string to log.
+     * @return true if successful, false if buffer overflow would occur.
+     */
+    bool log(std::u32string_view str) noexcept;
+
+    /**
+     * @brief Log a wide string, transcoded to UTF-8.
+     * 
+     * wchar_t strings are treated as UTF-16 or UTF-32 depending on the
+     * platform's wchar_t size.
+     * 
+     * @param str The wide string to log.
+     * @return true if successful, false if buffer overflow would occur.
+     */
+    inline bool log(std::wstring_view str) noexcept {
+        if constexpr (sizeof(wchar_t) == sizeof(char16_t)) {
+            return log(std::u16string_view(reinterpret_cast<const char16_t*>(str.data()), str.size()));
+        } else {
+            return log(std::u32string_view(reinterpret_cast<const char32_t*>(str.data()), str.size()));
+        }
+    }
+
     /**
      * @brief Log an integer value as ASCII text with null terminator.
      * 
@@ -315,6 +866,39 @@ public:
         return *this;
     }
 
+    /**
+     * @brief Stream insertion operator for UTF-16 strings.
+     * 
+     * @param str The UTF-16 string to log.
+     * @return Reference to this Logger for chaining.
+     */
+    inline Logger& operator<<(std::u16string_view str) noexcept {
+        log(str);
+        return *this;
+    }
+
+    /**
+     * @brief Stream insertion operator for UTF-32 strings.
+     * 
+     * @param str The UTF-32 string to log.
+     * @return Reference to this Logger for chaining.
+     */
+    inline Logger& operator<<(std::u32string_view str) noexcept {
+        log(str);
+        return *this;
+    }
+
+    /**
+     * @brief Stream insertion operator for wide strings.
+     * 
+     * @param str The wide string to log.
+     * @return Reference to this Logger for chaining.
+     */
+    inline Logger& operator<<(std::wstring_view str) noexcept {
+        log(str);
+        return *this;
+    }
+
     /**
      * @brief Stream insertion operator for integral types.
      * 
@@ -342,20 +926,171 @@ public:
     Logger& operator<<(std::ios_base& (*manip)(std::ios_base&)) noexcept;
 
 private:
+    friend class SiteSketch;  // writes RecordType::SiteStats records through write_record()
+
     /**
-     * @brief Helper function to log a formatted string with null terminator.
+     * @brief Helper function to log a formatted string in the current string format.
      * 
      * @param str Pointer to the formatted string buffer.
-     * @param length Length of the string (without null terminator).
+     * @param length Length of the string (without null terminator or length prefix).
+     * @param suffix Extra bytes appended to the field (e.g. kTruncationMarker).
+     * @return true if successful, false if buffer overflow would occur.
+     */
+    bool log_formatted_string(const char* str, std::size_t length, std::string_view suffix = {}) noexcept;
+
+    /**
+     * @brief Helper function to transcode UTF-16/UTF-32 into the buffer as UTF-8.
+     * 
+     * @tparam CharT char16_t or char32_t.
+     * @param str Pointer to the code units.
+     * @param length Number of code units.
      * @return true if successful, false if buffer overflow would occur.
      */
-    bool log_formatted_string(const char* str, std::size_t length) noexcept;
+    template<typename CharT>
+    bool log_unicode(const CharT* str, std::size_t length) noexcept;
+
+    /**
+     * @brief Write a complete record in one step.
+     * 
+     * @param type Record type.
+     * @param level Record severity.
+     * @param tag Record tag.
+     * @param payload Pointer to the payload bytes.
+     * @param size Number of payload bytes.
+     * @return true if written, false if it does not fit (nothing is counted as dropped).
+     */
+    bool write_record(RecordType type, Level level, uint16_t tag, const uint8_t* payload, std::size_t size) noexcept;
+
+    /**
+     * @brief Build the RecordMetadata block for a record started now.
+     * 
+     * @param site Call-site/format ID.
+     * @return Metadata with the current time relative to m_epoch_ns.
+     */
+    RecordMetadata make_metadata(uint32_t site) const noexcept;
+
+    /**
+     * @brief Write a BufferHeader at the current (empty) buffer's start.
+     */
+    void write_buffer_header() noexcept;
+
+    /**
+     * @brief Write the pending dropped counts as a gap record and clear them.
+     * 
+     * @return true if written, false if it does not fit.
+     */
+    bool write_gap_record() noexcept;
+
+    /**
+     * @brief Record a rejected write.
+     * 
+     * Sets the overflow flag, marks the open record (if any) as failed and
+     * updates the loss counters. Writes inside a record are counted as a
+     * dropped record once, by end_record().
+     * 
+     * @param bytes Size of the rejected write.
+     */
+    inline void mark_overflow(std::size_t bytes) noexcept {
+        m_overflow = true;
+        m_record_failed = true;
+        m_dropped_bytes += bytes;
+        m_dropped_records += m_record_start == kNoRecord;
+    }
+
+    /**
+     * @brief Commit bytes written at the current position.
+     * 
+     * Field writes and end_record() commit through here, so the threshold
+     * check costs one compare per write. Writes that set m_position directly
+     * (record headers, gap and site-stats records) repeat the compare.
+     * 
+     * @param size Number of bytes written.
+     */
+    inline void advance(std::size_t size) noexcept {
+        m_position += size;
+        if (m_position >= m_signal_position) {
+            signal_threshold();
+        }
+    }
+
+    /**
+     * @brief Handle m_position reaching m_signal_position (slow path of advance()).
+     */
+    void signal_threshold() noexcept;
+
+    /**
+     * @brief Clear the high watermark state if the fill level dropped below the low one.
+     */
+    void check_low_watermark() noexcept;
+
+    /**
+     * @brief Discard the record that starts at start and count it as dropped.
+     * 
+     * @param start Offset of the record's header.
+     */
+    void drop_record(std::size_t start) noexcept;
+
+    /**
+     * @brief Recompute m_signal_position from the armed notifier and watermark.
+     */
+    inline void update_signal_position() noexcept {
+        std::size_t position = m_notify_armed ? m_notify_threshold : kNoSignal;
+        if (!m_above_high && m_high_watermark < position) {
+            position = m_high_watermark;
+        }
+        m_signal_position = position;
+    }
+
+    /// Value of m_record_start when no record is open
+    static constexpr std::size_t kNoRecord = std::numeric_limits<std::size_t>::max();
+
+    /// Value of m_signal_position when no signal is armed
+    static constexpr std::size_t kNoSignal = std::numeric_limits<std::size_t>::max();
 
     uint8_t* m_buffer;         ///< Pointer to the user-provided buffer
     std::size_t m_capacity;    ///< Total capacity of the buffer in bytes
     std::size_t m_position;    ///< Current write position in the buffer
     bool m_overflow;           ///< Flag indicating if overflow has occurred
     IntFormat m_int_format;    ///< Current integer format setting
+    StringFormat m_string_format; ///< Current string format setting
+    std::size_t m_max_field_length; ///< Maximum string bytes per field
+    std::size_t m_record_start; ///< Offset of the open record's header, or kNoRecord
+    bool m_record_failed;      ///< Flag indicating a write in the open record was rejected
+    Logger* m_parent;          ///< Logger this one was carved from by child(), or nullptr
+    bool m_gap_records;        ///< Flag enabling gap records on reset()/attach()
+    uint64_t m_dropped_records; ///< Records dropped since the last gap record
+    uint64_t m_dropped_bytes;  ///< Bytes dropped since the last gap record
+    bool m_sequence_numbers;   ///< Flag enabling per-record sequence numbers
+    bool m_have_sequence_base; ///< Flag indicating m_last_sequence is in this buffer
+    uint64_t m_next_sequence;  ///< Sequence number of the next record
+    uint64_t m_last_sequence;  ///< Sequence number of the last committed record
+    bool m_buffer_header;      ///< Flag enabling a BufferHeader per epoch
+    std::size_t m_header_size; ///< Size of the BufferHeader at offset 0 of this buffer, or 0
+    uint32_t m_epoch;          ///< Number of buffer headers written
+    uint64_t m_format_hash;    ///< Format hash stored in buffer headers
+    bool m_record_metadata;    ///< Flag enabling a RecordMetadata block per record
+    uint64_t m_epoch_ns;       ///< steady_clock time record timestamps are relative to
+    Notifier* m_notifier;      ///< Notifier signalled at m_notify_threshold, or nullptr
+    std::size_t m_notify_threshold; ///< Fill level that signals m_notifier, or kNoSignal
+    bool m_notify_armed;       ///< Flag indicating m_notifier has not been signalled this epoch
+    std::size_t m_high_watermark; ///< Fill level that raises m_above_high, or kNoWatermark
+    std::size_t m_low_watermark; ///< Fill level below which m_above_high clears
+    WatermarkHook m_watermark_hook; ///< Called on watermark crossings, or nullptr
+    void* m_watermark_context; ///< Passed to m_watermark_hook
+    bool m_above_high;         ///< Flag indicating the high watermark was crossed
+    std::size_t m_signal_position; ///< Smallest armed notify/watermark position, or kNoSignal
+    SiteSketch* m_drop_sketch; ///< Sketch fed with dropped records, or nullptr
+    uint32_t m_record_key;     ///< Site (or tag) of the open record, for m_drop_sketch
 };
 
+/**
+ * @brief Exchange the buffers, write state and settings of two loggers.
+ * 
+ * @param a First logger.
+ * @param b Second logger.
+ */
+inline void swap(Logger& a, Logger& b) noexcept {
+    a.swap(b);
+}
+
 } // namespace log_buffer
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace log_buffer {
+
+/**
+ * @enum Level
+ * @brief Severity of a framed record.
+ */
+enum class Level : uint8_t {
+    Trace,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Fatal
+};
+
+/**
+ * @brief Number of Level values.
+ */
+inline constexpr std::size_t kLevelCount = 6;
+
+/**
+ * @brief Get the lowercase name of a level ("trace" ... "fatal").
+ *
+ * @param level The level.
+ * @return Static string, or "unknown" for out-of-range values.
+ */
+inline constexpr const char* level_name(Level level) noexcept {
+    constexpr const char* kNames[kLevelCount] = {"trace", "debug", "info", "warn", "error", "fatal"};
+    return static_cast<std::size_t>(level) < kLevelCount ? kNames[static_cast<std::size_t>(level)] : "unknown";
+}
+
+/**
+ * @enum RecordType
+ * @brief Kind of a framed record, stored in RecordHeader::type.
+ */
+enum class RecordType : uint8_t {
+    Padding = 0,  ///< Unused slot; a zero size field always means padding
+    Log = 1,      ///< Record written with Logger::begin_record()/end_record()
+    Gap = 2,      ///< Loss report: varint dropped records, then varint dropped bytes
+    SiteStats = 3, ///< Heaviest call sites: varint total, varint count, then (varint key, varint count) pairs
+    BlockSummary = 4 ///< Token filter of the block that follows: BlockSummaryHeader, then the filter bits
+};
+
+/**
+ * @brief Bits of RecordHeader::type holding the RecordType; the rest are flags.
+ */
+inline constexpr uint8_t kRecordTypeMask = 0x1F;
+
+/**
+ * @brief Flag: a RecordMetadata block (site and timestamp) follows the header.
+ */
+inline constexpr uint8_t kRecordFlagMetadata = 0x20;
+
+/**
+ * @brief Flag: a varint sequence number follows the header.
+ */
+inline constexpr uint8_t kRecordFlagSequence = 0x40;
+
+/**
+ * @brief Flag: the sequence number is absolute rather than a delta from the
+ *        previous sequenced record in the buffer.
+ */
+inline constexpr uint8_t kRecordFlagSequenceBase = 0x80;
+
+/**
+ * @brief Alignment of every framed record relative to the start of the buffer.
+ *
+ * Records start at multiples of this offset, so headers are naturally aligned
+ * whenever the buffer itself is. Gaps between records are zero-filled and
+ * read back as padding.
+ */
+inline constexpr std::size_t kRecordAlignment = 8;
+
+/**
+ * @struct RecordHeader
+ * @brief Fixed header at the start of every framed record.
+ *
+ * The header is followed by a RecordMetadata block if kRecordFlagMetadata is
+ * set, then by a varint sequence number if kRecordFlagSequence is set, then
+ * by the payload: the fields logged while the record was open,
+ * in the Logger's usual field encodings.
+ */
+struct RecordHeader {
+    uint32_t size;  ///< Header plus payload bytes, excluding trailing alignment padding
+    uint8_t type;   ///< RecordType in the low bits, kRecordFlag* in the high bits
+    uint8_t level;  ///< Level
+    uint16_t tag;   ///< User-defined module/component tag
+};
+
+static_assert(sizeof(RecordHeader) == kRecordAlignment, "RecordHeader must fill one alignment slot");
+
+/**
+ * @brief Timestamp value stored when the real offset does not fit in 32 bits.
+ */
+inline constexpr uint32_t kTimestampSaturated = UINT32_MAX;
+
+/**
+ * @struct RecordMetadata
+ * @brief Optional fixed block after a RecordHeader (format version 2).
+ *
+ * Present when kRecordFlagMetadata is set. Keeps the record prefix at 16
+ * naturally aligned bytes, so type, length, site and time can be read with
+ * plain loads straight from a mapped dump.
+ */
+struct RecordMetadata {
+    uint32_t site;          ///< User-defined call-site/format ID (0 if unset)
+    uint32_t timestamp_us;  ///< Microseconds since the buffer epoch (BufferHeader::steady_ns),
+                            ///< or kTimestampSaturated
+};
+
+static_assert(sizeof(RecordMetadata) == kRecordAlignment, "RecordMetadata must fill one alignment slot");
+
+/**
+ * @struct BlockSummaryHeader
+ * @brief Payload prefix of a RecordType::BlockSummary record.
+ *
+ * Followed by filter_bits / 8 bytes of Bloom filter. The summarized block
+ * starts right after the summary record, so a reader that finds no match
+ * can skip block_size bytes without touching them.
+ */
+struct BlockSummaryHeader {
+    uint32_t block_size;   ///< Bytes of the block that follows the summary record
+    uint32_t filter_bits;  ///< Filter size in bits (a power of two, 0 if the block has no tokens)
+    uint32_t tokens;       ///< Distinct tokens added to the filter
+    uint8_t hashes;        ///< Bits set per token
+    uint8_t reserved[3];   ///< Zero
+};
+
+static_assert(sizeof(BlockSummaryHeader) == 2 * kRecordAlignment, "BlockSummaryHeader must fill two alignment slots");
+
+/**
+ * @brief Magic number at offset 0 of a buffer that starts with a BufferHeader ("LGBF").
+ */
+inline constexpr uint32_t kBufferMagic = 0x4642474C;
+
+/**
+ * @brief Version of the buffer and record layout written by this library.
+ *
+ * 1: BufferHeader and RecordHeader. 2: adds RecordMetadata.
+ */
+inline constexpr uint16_t kBufferFormatVersion = 2;
+
+/**
+ * @struct BufferHeader
+ * @brief Producer metadata written once per buffer epoch at offset 0.
+ *
+ * Enabled with Logger::set_buffer_header(). Everything that is the same for
+ * all records of a buffer (process, thread, clock calibration, format table)
+ * is stored here once, which makes a raw dump of the buffer self-describing.
+ * Records follow at offset header_size.
+ */
+struct BufferHeader {
+    uint32_t magic;             ///< kBufferMagic
+    uint16_t version;           ///< kBufferFormatVersion of the writer
+    uint16_t header_size;       ///< Size of this header; records start here
+    uint32_t pid;               ///< Process ID of the producer
+    uint32_t tid;               ///< Thread ID of the producer
+    char thread_name[16];       ///< Producer thread name, NUL-padded
+    uint64_t steady_ns;         ///< steady_clock time when the epoch started (RecordMetadata time base)
+    uint64_t system_ns;         ///< system_clock time at the same instant (maps steady to wall time)
+    uint64_t format_hash;       ///< User-supplied hash of the format/schema table (0 if unset)
+    uint64_t first_sequence;    ///< Sequence number the first record of the epoch gets
+    uint32_t epoch;             ///< Number of headers this Logger wrote before this one
+    uint32_t reserved;          ///< Zero
+};
+
+static_assert(sizeof(BufferHeader) % kRecordAlignment == 0, "Records after the header must stay aligned");
+
+/**
+ * @brief Round an offset up to the next record boundary.
+ *
+ * @param offset Offset from the start of the buffer.
+ * @return The smallest multiple of kRecordAlignment not less than offset.
+ */
+inline constexpr std::size_t align_record(std::size_t offset) noexcept {
+    return (offset + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+} // namespace log_buffer
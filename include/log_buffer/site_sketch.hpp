@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "log_buffer/encoding.hpp"
+#include "log_buffer/record.hpp"
+
+namespace log_buffer {
+
+class Logger;
+
+/**
+ * @struct SiteCount
+ * @brief Estimated weight of one call site.
+ */
+struct SiteCount {
+    uint32_t key;    ///< Site ID (RecordMetadata::site), or the tag for records without metadata
+    uint64_t count;  ///< Estimated weight; never below the true weight
+};
+
+/**
+ * @class SiteSketch
+ * @brief Fixed-memory count-min sketch with a top-K list of the heaviest sites.
+ *
+ * Answers "which call sites are filling the buffers" without keeping a
+ * counter per site: add() hashes a key into one counter per row and the
+ * estimate is the smallest of them, so it can overcount (by colliding keys)
+ * but never undercount. The K keys with the largest estimates seen so far
+ * are tracked alongside. All memory is allocated by the constructor.
+ *
+ * Two places feed a sketch:
+ * - Drainer::set_site_sketch() adds every drained record, weighted by its
+ *   size, and periodically writes the heaviest sites to the sink as a
+ *   RecordType::SiteStats record.
+ * - Logger::set_drop_sketch() adds every record the Logger drops, weighted 1,
+ *   on the producer side; emit() the sketch into a buffer with room to
+ *   report it.
+ *
+ * Keys are RecordMetadata::site for records with metadata (see
+ * Logger::set_record_metadata()) and the record tag otherwise.
+ *
+ * @example
+ * @code
+ * SiteSketch sketch;
+ * drainer.set_site_sketch(&sketch, std::chrono::seconds(10));
+ * // Offline: decode_site_stats() on each RecordType::SiteStats record
+ * @endcode
+ *
+ * @note Thread Safety: not thread-safe; use one sketch per thread.
+ */
+class SiteSketch {
+public:
+    /**
+     * @brief Allocate the counters.
+     *
+     * Estimates exceed the true weight by at most 2 * total() / width with
+     * probability 1 - 2^-depth.
+     *
+     * @param width Counters per row (rounded up to a power of two).
+     * @param depth Number of rows (hash functions), at least 1.
+     * @param top Number of heaviest sites to track, at least 1.
+     */
+    explicit SiteSketch(std::size_t width = 1024, std::size_t depth = 4, std::size_t top = 8);
+
+    SiteSketch(const SiteSketch&) = delete;
+    SiteSketch& operator=(const SiteSketch&) = delete;
+
+    /**
+     * @brief Count weight against a key.
+     *
+     * @param key Site ID or tag.
+     * @param weight Amount to add (e.g. bytes or records).
+     */
+    void add(uint32_t key, uint64_t weight = 1) noexcept;
+
+    /**
+     * @brief Count every Log record of a buffer, weighted by its size in bytes.
+     *
+     * @param data Start of a buffer of framed records (may begin with a BufferHeader).
+     * @param size Number of valid bytes.
+     */
+    void add_buffer(const uint8_t* data, std::size_t size) noexcept;
+
+    /**
+     * @brief Estimated weight of a key.
+     *
+     * @param key Site ID or tag.
+     * @return The smallest of the key's counters.
+     */
+    uint64_t estimate(uint32_t key) const noexcept;
+
+    /**
+     * @brief Copy out the heaviest keys, heaviest first.
+     *
+     * @param out Output array.
+     * @param max Capacity of out.
+     * @return Number of entries written.
+     */
+    std::size_t top(SiteCount* out, std::size_t max) const noexcept;
+
+    /**
+     * @brief Write the heaviest keys as a RecordType::SiteStats record.
+     *
+     * Payload: varint total(), varint entry count, then a varint key and a
+     * varint count per entry, heaviest first. Read it with decode_site_stats().
+     * The payload is assembled in the sketch's own scratch storage, so this
+     * modifies the sketch like add() does.
+     *
+     * @param logger Logger to write to; no record may be open.
+     * @param level Record severity.
+     * @param tag Record tag.
+     * @return true if written, false if it did not fit.
+     */
+    bool emit(Logger& logger, Level level = Level::Info, uint16_t tag = 0) noexcept;
+
+    /**
+     * @brief Forget everything counted, e.g. to start a new reporting window.
+     */
+    void clear() noexcept;
+
+    /// Total weight added since construction or clear().
+    inline uint64_t total() const noexcept { return m_total; }
+
+    /// Capacity of the top-K list.
+    inline std::size_t top_capacity() const noexcept { return m_top_capacity; }
+
+    /// Largest payload emit() can write.
+    inline std::size_t max_payload_size() const noexcept { return (2 + 2 * m_top_capacity) * kMaxVarintSize; }
+
+private:
+    std::size_t m_mask;                     ///< Row width minus one
+    std::size_t m_depth;                    ///< Number of rows
+    std::unique_ptr<uint64_t[]> m_counters; ///< depth rows of (m_mask + 1) counters
+    std::size_t m_top_capacity;             ///< K
+    std::size_t m_top_size;                 ///< Entries in m_top
+    std::unique_ptr<SiteCount[]> m_top;     ///< Heaviest keys, unordered
+    std::unique_ptr<SiteCount[]> m_sorted;  ///< Sorted copy of m_top for emit()
+    std::unique_ptr<uint8_t[]> m_scratch;   ///< Payload assembly for emit()
+    uint64_t m_total;                       ///< Sum of all weights
+};
+
+} // namespace log_buffer
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "log_buffer/decoder.hpp"
+#include "log_buffer/record.hpp"
+
+namespace log_buffer {
+
+/**
+ * @brief Magic number at the start of a time index file ("LGIX").
+ */
+inline constexpr uint32_t kTimeIndexMagic = 0x5849474C;
+
+/**
+ * @brief Version of the time index layout written by this library.
+ */
+inline constexpr uint16_t kTimeIndexVersion = 1;
+
+/**
+ * @struct TimeIndexHeader
+ * @brief Fixed header at offset 0 of a time index file; TimeIndexEntry records follow.
+ */
+struct TimeIndexHeader {
+    uint32_t magic;        ///< kTimeIndexMagic
+    uint16_t version;      ///< kTimeIndexVersion of the writer
+    uint16_t entry_size;   ///< sizeof(TimeIndexEntry) of the writer
+    uint64_t reserved;     ///< Zero
+};
+
+/**
+ * @struct TimeIndexEntry
+ * @brief Time span and location of one block of a dump.
+ *
+ * Times are system_clock nanoseconds (BufferHeader::system_ns plus the
+ * record's RecordMetadata::timestamp_us).
+ */
+struct TimeIndexEntry {
+    uint64_t first_ns;  ///< Earliest record time in the block
+    uint64_t last_ns;   ///< Latest record time in the block
+    uint64_t offset;    ///< File offset of the block
+    uint64_t size;      ///< Bytes of the block
+};
+
+static_assert(sizeof(TimeIndexHeader) == 2 * kRecordAlignment, "TimeIndexHeader must fill two alignment slots");
+static_assert(sizeof(TimeIndexEntry) == 4 * kRecordAlignment, "TimeIndexEntry must fill four alignment slots");
+
+/**
+ * @brief Get the wall-clock time of a record.
+ *
+ * @param record Record with metadata.
+ * @param header Buffer header in effect for the record (RecordReader::buffer_header()).
+ * @param time_ns Receives system_clock nanoseconds.
+ * @return false if the record has no metadata, there is no header, or the
+ *         timestamp saturated.
+ */
+inline bool record_time_ns(const RecordView& record, const BufferHeader* header, uint64_t& time_ns) noexcept {
+    if (!record.has_metadata || header == nullptr || record.timestamp_us == kTimestampSaturated) {
+        return false;
+    }
+    time_ns = header->system_ns + uint64_t{record.timestamp_us} * 1000;
+    return true;
+}
+
+/**
+ * @brief Find the earliest and latest record times of a block.
+ *
+ * @param data Block bytes (one or more buffers with BufferHeaders).
+ * @param size Number of bytes.
+ * @param first_ns Receives the earliest record time.
+ * @param last_ns Receives the latest record time.
+ * @return false if no record of the block has a time (see record_time_ns()).
+ */
+bool block_time_range(const uint8_t* data, std::size_t size, uint64_t& first_ns, uint64_t& last_ns) noexcept;
+
+/**
+ * @class TimeIndexWriter
+ * @brief Appends one TimeIndexEntry per timed block to an index file, alongside a dump.
+ *
+ * Call add() from the sink with every chunk written to the dump, in write
+ * order; it tracks the dump offset itself. Chunks holding records with
+ * metadata (Logger::set_buffer_header() and set_record_metadata()) get an
+ * entry, others (untimed buffers, block summaries) only advance the offset.
+ * Each entry is a single small write() on the sink's thread.
+ *
+ * @example
+ * @code
+ * TimeIndexWriter index;
+ * index.open("app.log.idx");
+ * Drainer drainer(pool, [&](const uint8_t* data, std::size_t size) {
+ *     ::write(fd, data, size);
+ *     index.add(data, size);
+ * });
+ * @endcode
+ */
+class TimeIndexWriter {
+public:
+    inline TimeIndexWriter() noexcept : m_fd(-1), m_offset(0) {}
+    inline ~TimeIndexWriter() { close(); }
+
+    TimeIndexWriter(const TimeIndexWriter&) = delete;
+    TimeIndexWriter& operator=(const TimeIndexWriter&) = delete;
+
+    /**
+     * @brief Create (or truncate) an index file and write its header.
+     *
+     * @param path Index file.
+     * @param offset Dump offset of the first chunk that will be added.
+     * @return false if the file cannot be created or written, or on platforms
+     *         without POSIX file I/O.
+     */
+    bool open(const char* path, uint64_t offset = 0) noexcept;
+
+    /**
+     * @brief Close the index file.
+     */
+    void close() noexcept;
+
+    /**
+     * @brief Account for one chunk written to the dump.
+     *
+     * @param data Chunk bytes.
+     * @param size Number of bytes.
+     * @return false if an entry was due but could not be written.
+     */
+    bool add(const uint8_t* data, std::size_t size) noexcept;
+
+    /// Dump offset of the next chunk.
+    inline uint64_t offset() const noexcept { return m_offset; }
+
+private:
+    int m_fd;           ///< Index file, or -1
+    uint64_t m_offset;  ///< Dump offset of the next chunk
+};
+
+/**
+ * @struct TimeRangeStats
+ * @brief What TimeIndex::extract() read.
+ */
+struct TimeRangeStats {
+    uint64_t blocks = 0;   ///< Blocks decoded
+    uint64_t bytes = 0;    ///< Bytes of the decoded blocks
+    uint64_t records = 0;  ///< Records decoded
+    uint64_t matches = 0;  ///< Records passed to the callback
+};
+
+/**
+ * @class TimeIndex
+ * @brief Loaded time index: finds the blocks of a dump that overlap a time range.
+ *
+ * Entries are sorted by first_ns on load, since buffers from several
+ * producers reach the dump out of time order. A running maximum of last_ns
+ * makes both ends of a range a binary search: the candidates are the
+ * entries from the first one whose running maximum reaches the start to the
+ * last one starting before the end.
+ *
+ * @example
+ * @code
+ * TimeIndex index;
+ * MappedDump dump;
+ * if (index.load("app.log.idx") && dump.open("app.log")) {
+ *     dump.advise_random();
+ *     index.extract(dump.data(), dump.size(), from_ns, to_ns,
+ *                   [](const RecordView& record, uint64_t time_ns) { ... });
+ * }
+ * @endcode
+ */
+class TimeIndex {
+public:
+    /// Called with each record in range and its system_clock time.
+    using Callback = std::function<void(const RecordView& record, uint64_t time_ns)>;
+
+    /**
+     * @brief Read an index file.
+     *
+     * @param path Index file written by TimeIndexWriter.
+     * @return false if it cannot be read or is not a time index.
+     */
+    bool load(const char* path);
+
+    /**
+     * @brief Use entries already in memory (sorted and indexed as by load()).
+     *
+     * @param entries Index entries in any order.
+     */
+    void assign(std::vector<TimeIndexEntry> entries);
+
+    /**
+     * @brief Find the entries that may hold records in [from_ns, to_ns].
+     *
+     * @param from_ns Start of the range (inclusive).
+     * @param to_ns End of the range (inclusive).
+     * @param begin Receives the first candidate entry.
+     * @param end Receives one past the last candidate entry.
+     */
+    void candidates(uint64_t from_ns, uint64_t to_ns, std::size_t& begin, std::size_t& end) const noexcept;
+
+    /**
+     * @brief Decode the records in [from_ns, to_ns] from the blocks that overlap it.
+     *
+     * Blocks are visited in order of first_ns and their records in write
+     * order; entries that lie outside the dump are ignored.
+     *
+     * @param data Dump bytes (e.g. MappedDump::data()).
+     * @param size Number of bytes.
+     * @param from_ns Start of the range (inclusive).
+     * @param to_ns End of the range (inclusive).
+     * @param on_record Called with each record in range.
+     * @return Counts of blocks and records read.
+     */
+    TimeRangeStats extract(const uint8_t* data, std::size_t size, uint64_t from_ns, uint64_t to_ns,
+                           const Callback& on_record) const;
+
+    /// Entries sorted by first_ns.
+    inline const std::vector<TimeIndexEntry>& entries() const noexcept { return m_entries; }
+
+private:
+    std::vector<TimeIndexEntry> m_entries;  ///< Entries sorted by first_ns
+    std::vector<uint64_t> m_max_last;       ///< Running maximum of last_ns over m_entries
+};
+
+} // namespace log_buffer
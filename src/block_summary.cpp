@@ -0,0 +1,148 @@
+#include "log_buffer/block_summary.hpp"
+#include "detail.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace log_buffer {
+
+namespace {
+
+/// Call f(token) for every token of a Log record's string fields.
+template <typename F>
+inline void for_each_record_token(const RecordView& record, StringFormat format, F&& f) {
+    FieldReader fields(record, format);
+    std::string_view field;
+    while (fields.remaining() != 0 && fields.read_string(field)) {
+        for_each_token(field, f);
+    }
+}
+
+} // namespace
+
+uint64_t hash_token(std::string_view token) noexcept {
+    // FNV-1a over the bytes, then a finalizer so the low and high halves are independent
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (char c : token) {
+        h = (h ^ static_cast<uint8_t>(c)) * 0x100000001B3ULL;
+    }
+    return detail::mix(h);
+}
+
+bool block_may_contain(const BlockSummaryHeader& header, const uint8_t* filter, uint64_t hash) noexcept {
+    if (header.filter_bits == 0) {
+        return false;
+    }
+    return detail::for_each_probe(hash, header.hashes, header.filter_bits - 1, [&](uint64_t, uint64_t bit) {
+        return (filter[bit >> 3] & (1u << (bit & 7))) != 0;
+    });
+}
+
+BlockSummarizer::BlockSummarizer(StringFormat format, uint32_t bits_per_token, std::size_t max_filter_bytes)
+    : m_format(format), m_bits_per_token(bits_per_token < 1 ? 1 : bits_per_token),
+      // k = ln 2 * bits per token minimizes the false positive rate
+      m_hashes(static_cast<uint8_t>(std::clamp((m_bits_per_token * 693u + 500u) / 1000u, 1u, 16u))),
+      m_max_filter_bits(64) {
+    // Largest power of two that fits, at least one 64-bit word
+    while (m_max_filter_bits * 2 <= max_filter_bytes * 8) {
+        m_max_filter_bits *= 2;
+    }
+}
+
+void BlockSummarizer::summarize(const uint8_t* data, std::size_t size) {
+    m_tokens.clear();
+    RecordReader reader(data, size);
+    RecordView record;
+    while (reader.next(record)) {
+        if (record.type == RecordType::Log) {
+            for_each_record_token(record, m_format,
+                                  [this](std::string_view token) { m_tokens.push_back(hash_token(token)); });
+        }
+    }
+    std::sort(m_tokens.begin(), m_tokens.end());
+    m_tokens.erase(std::unique(m_tokens.begin(), m_tokens.end()), m_tokens.end());
+
+    std::size_t bits = 0;
+    if (!m_tokens.empty()) {
+        bits = std::min(detail::round_up_pow2(std::max<std::size_t>(64, m_tokens.size() * m_bits_per_token)),
+                        m_max_filter_bits);
+    }
+    const std::size_t record_size = sizeof(RecordHeader) + sizeof(BlockSummaryHeader) + bits / 8;
+    m_record.assign(record_size, 0);
+
+    RecordHeader header{static_cast<uint32_t>(record_size), static_cast<uint8_t>(RecordType::BlockSummary),
+                        static_cast<uint8_t>(Level::Info), 0};
+    BlockSummaryHeader summary{static_cast<uint32_t>(size), static_cast<uint32_t>(bits),
+                               static_cast<uint32_t>(m_tokens.size()), m_hashes, {0, 0, 0}};
+    std::memcpy(m_record.data(), &header, sizeof(header));
+    std::memcpy(m_record.data() + sizeof(header), &summary, sizeof(summary));
+    if (bits != 0) {
+        uint8_t* filter = m_record.data() + sizeof(header) + sizeof(summary);
+        for (uint64_t hash : m_tokens) {
+            detail::for_each_probe(hash, m_hashes, bits - 1, [filter](uint64_t, uint64_t bit) {
+                filter[bit >> 3] |= static_cast<uint8_t>(1u << (bit & 7));
+                return true;
+            });
+        }
+    }
+}
+
+BlockSearchStats search_blocks(const uint8_t* data, std::size_t size, std::string_view query, StringFormat format,
+                               const std::function<void(const RecordView&)>& on_match) {
+    BlockSearchStats stats;
+    std::vector<std::string_view> tokens;
+    for_each_token(query, [&](std::string_view token) { tokens.push_back(token); });
+    std::sort(tokens.begin(), tokens.end());
+    tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+    if (tokens.empty()) {
+        return stats;
+    }
+    std::vector<uint64_t> hashes;
+    for (std::string_view token : tokens) {
+        hashes.push_back(hash_token(token));
+    }
+    std::vector<bool> found(tokens.size());
+
+    RecordReader reader(data, size);
+    RecordView record;
+    while (reader.next(record)) {
+        if (record.type == RecordType::BlockSummary) {
+            BlockSummaryHeader summary;
+            const uint8_t* filter = nullptr;
+            if (!decode_block_summary(record, summary, filter)) {
+                continue;
+            }
+            ++stats.blocks;
+            const bool candidate = std::all_of(hashes.begin(), hashes.end(), [&](uint64_t hash) {
+                return block_may_contain(summary, filter, hash);
+            });
+            const std::size_t block_start = reader.offset();
+            if (!candidate && summary.block_size <= size - block_start) {
+                ++stats.skipped;
+                stats.bytes_skipped += summary.block_size;
+                reader.seek(block_start + summary.block_size);
+            }
+            continue;
+        }
+        if (record.type != RecordType::Log) {
+            continue;
+        }
+        ++stats.records;
+        std::fill(found.begin(), found.end(), false);
+        std::size_t missing = tokens.size();
+        for_each_record_token(record, format, [&](std::string_view token) {
+            const auto it = std::lower_bound(tokens.begin(), tokens.end(), token);
+            if (it != tokens.end() && *it == token && !found[it - tokens.begin()]) {
+                found[it - tokens.begin()] = true;
+                --missing;
+            }
+        });
+        if (missing == 0) {
+            ++stats.matches;
+            on_match(record);
+        }
+    }
+    return stats;
+}
+
+} // namespace log_buffer
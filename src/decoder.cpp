@@ -0,0 +1,335 @@
+#include "log_buffer/decoder.hpp"
+#include "log_buffer/encoding.hpp"
+#include "log_buffer/logger.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LOG_BUFFER_HAVE_MMAP 1
+#endif
+
+namespace log_buffer {
+
+RecordReader::RecordReader(const uint8_t* data, std::size_t size) noexcept
+    : m_data(data), m_size(size), m_offset(0), m_malformed(false), m_have_sequence(false),
+      m_last_sequence(0), m_missing_records(0), m_records_start(0), m_have_header(false), m_header{} {
+    if (read_buffer_header(data, size, m_header)) {
+        m_have_header = true;
+        m_records_start = align_record(m_header.header_size);
+        m_offset = m_records_start;
+    }
+}
+
+RecordReader::RecordReader(const Logger& logger) noexcept
+    : RecordReader(logger.data(), logger.bytes_written()) {}
+
+bool RecordReader::next(RecordView& record) noexcept {
+    while (m_offset + sizeof(RecordHeader) <= m_size) {
+        RecordHeader header;
+        std::memcpy(&header, m_data + m_offset, sizeof(header));
+        
+        if (header.size == 0) {
+            // Padding slot (zero fill between records or an unfinished header)
+            m_offset += kRecordAlignment;
+            continue;
+        }
+        if (header.size == kBufferMagic
+            && read_buffer_header(m_data + m_offset, m_size - m_offset, m_header)) {
+            // Next buffer of a concatenated dump; its sequences start afresh
+            m_have_header = true;
+            m_have_sequence = false;
+            m_offset += align_record(m_header.header_size);
+            continue;
+        }
+        if (header.size < sizeof(RecordHeader) || header.size > m_size - m_offset) {
+            m_malformed = true;
+            return false;
+        }
+        
+        const uint8_t* begin = m_data + m_offset;
+        const uint8_t* end = begin + header.size;
+        const uint8_t* payload = begin + sizeof(RecordHeader);
+        record.has_metadata = false;
+        record.site = 0;
+        record.timestamp_us = 0;
+        if (header.type & kRecordFlagMetadata) {
+            if (header.size < sizeof(RecordHeader) + sizeof(RecordMetadata)) {
+                m_malformed = true;
+                return false;
+            }
+            RecordMetadata metadata;
+            std::memcpy(&metadata, payload, sizeof(metadata));
+            record.has_metadata = true;
+            record.site = metadata.site;
+            record.timestamp_us = metadata.timestamp_us;
+            payload += sizeof(metadata);
+        }
+        record.has_sequence = false;
+        record.sequence = 0;
+        record.sequence_gap = 0;
+        if (header.type & kRecordFlagSequence) {
+            uint64_t value = 0;
+            payload = decode_varint(payload, end, value);
+            if (payload == nullptr) {
+                m_malformed = true;
+                return false;
+            }
+            if (header.type & kRecordFlagSequenceBase) {
+                record.sequence = value;
+            } else if (m_have_sequence) {
+                record.sequence = m_last_sequence + value;
+                record.sequence_gap = value > 0 ? value - 1 : 0;
+                m_missing_records += record.sequence_gap;
+            }
+            record.has_sequence = (header.type & kRecordFlagSequenceBase) || m_have_sequence;
+            m_have_sequence = record.has_sequence;
+            m_last_sequence = record.sequence;
+        }
+        
+        record.data = begin;
+        record.size = header.size;
+        record.type = static_cast<RecordType>(header.type & kRecordTypeMask);
+        record.level = static_cast<Level>(header.level);
+        record.tag = header.tag;
+        record.payload_data = payload;
+        record.payload_length = static_cast<std::size_t>(end - payload);
+        m_offset = align_record(m_offset + header.size);
+        if (m_offset > m_size) {
+            m_offset = m_size; // last record's padding did not fit
+        }
+        return true;
+    }
+    m_offset = m_size;
+    return false;
+}
+
+bool read_buffer_header(const uint8_t* data, std::size_t size, BufferHeader& header) noexcept {
+    if (size < sizeof(BufferHeader)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    // Newer writers may append fields; header_size tells us where records start
+    return header.magic == kBufferMagic && header.version <= kBufferFormatVersion
+        && header.header_size >= sizeof(BufferHeader) && header.header_size <= size;
+}
+
+bool MappedDump::open(const char* path) noexcept {
+    close();
+#ifdef LOG_BUFFER_HAVE_MMAP
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    bool ok = ::fstat(fd, &info) == 0;
+    if (ok && info.st_size > 0) {
+        void* mapped = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ok = mapped != MAP_FAILED;
+        if (ok) {
+            // Readers walk the file front to back
+            ::madvise(mapped, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+            m_data = static_cast<const uint8_t*>(mapped);
+            m_size = static_cast<std::size_t>(info.st_size);
+        }
+    }
+    ::close(fd);
+    return ok;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+void MappedDump::advise_random() noexcept {
+#ifdef LOG_BUFFER_HAVE_MMAP
+    if (m_data != nullptr) {
+        ::madvise(const_cast<uint8_t*>(m_data), m_size, MADV_RANDOM);
+    }
+#endif
+}
+
+void MappedDump::close() noexcept {
+#ifdef LOG_BUFFER_HAVE_MMAP
+    if (m_data != nullptr) {
+        ::munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+#endif
+}
+
+bool decode_gap(const RecordView& record, uint64_t& records, uint64_t& bytes) noexcept {
+    if (record.type != RecordType::Gap) {
+        return false;
+    }
+    const uint8_t* end = record.payload() + record.payload_size();
+    const uint8_t* p = decode_varint(record.payload(), end, records);
+    return p != nullptr && decode_varint(p, end, bytes) != nullptr;
+}
+
+bool decode_site_stats(const RecordView& record, SiteCount* out, std::size_t max, std::size_t& count,
+                       uint64_t& total) noexcept {
+    count = 0;
+    if (record.type != RecordType::SiteStats) {
+        return false;
+    }
+    const uint8_t* end = record.payload() + record.payload_size();
+    uint64_t entries = 0;
+    const uint8_t* p = decode_varint(record.payload(), end, total);
+    p = p != nullptr ? decode_varint(p, end, entries) : nullptr;
+    for (uint64_t i = 0; p != nullptr && i < entries; ++i) {
+        uint64_t key = 0;
+        uint64_t weight = 0;
+        p = decode_varint(p, end, key);
+        p = p != nullptr ? decode_varint(p, end, weight) : nullptr;
+        if (p != nullptr && key <= UINT32_MAX && count < max) {
+            out[count++] = SiteCount{static_cast<uint32_t>(key), weight};
+        }
+    }
+    return p != nullptr;
+}
+
+bool decode_block_summary(const RecordView& record, BlockSummaryHeader& header, const uint8_t*& filter) noexcept {
+    if (record.type != RecordType::BlockSummary || record.payload_size() < sizeof(BlockSummaryHeader)) {
+        return false;
+    }
+    std::memcpy(&header, record.payload(), sizeof(header));
+    filter = record.payload() + sizeof(header);
+    return (header.filter_bits & (header.filter_bits - 1)) == 0
+        && header.filter_bits / 8 <= record.payload_size() - sizeof(header);
+}
+
+namespace {
+
+void append_number(std::string& out, uint64_t value) {
+    char digits[20];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void append_escaped(std::string& out, std::string_view text) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    for (char c : text) {
+        const unsigned char byte = static_cast<unsigned char>(c);
+        if (byte < 0x20 || byte == 0x7F) {
+            const char escape[4] = {'\\', 'x', kHex[byte >> 4], kHex[byte & 0xF]};
+            out.append(escape, sizeof(escape));
+        } else {
+            out += c;
+        }
+    }
+}
+
+} // namespace
+
+void format_text(const uint8_t* data, std::size_t size, std::string& out, StringFormat format) {
+    RecordReader reader(data, size);
+    RecordView record;
+    while (reader.next(record)) {
+        out += level_name(record.level);
+        out += ' ';
+        append_number(out, record.tag);
+        if (record.has_sequence) {
+            out += " #";
+            append_number(out, record.sequence);
+        }
+        if (record.has_metadata) {
+            out += " @";
+            append_number(out, record.timestamp_us);
+            out += "us site=";
+            append_number(out, record.site);
+        }
+        out += ':';
+
+        if (record.type == RecordType::Gap) {
+            uint64_t records = 0;
+            uint64_t bytes = 0;
+            if (decode_gap(record, records, bytes)) {
+                out += " dropped ";
+                append_number(out, records);
+                out += " records, ";
+                append_number(out, bytes);
+                out += " bytes";
+            }
+        } else if (record.type == RecordType::BlockSummary) {
+            BlockSummaryHeader summary;
+            const uint8_t* filter = nullptr;
+            if (decode_block_summary(record, summary, filter)) {
+                out += " block summary ";
+                append_number(out, summary.block_size);
+                out += " bytes, ";
+                append_number(out, summary.tokens);
+                out += " tokens";
+            }
+        } else if (record.type == RecordType::SiteStats) {
+            SiteCount top[32];
+            std::size_t count = 0;
+            uint64_t total = 0;
+            if (decode_site_stats(record, top, 32, count, total)) {
+                out += " site stats total=";
+                append_number(out, total);
+                for (std::size_t i = 0; i < count; ++i) {
+                    out += ' ';
+                    append_number(out, top[i].key);
+                    out += '=';
+                    append_number(out, top[i].count);
+                }
+            }
+        } else {
+            FieldReader fields(record, format);
+            std::string_view field;
+            while (fields.remaining() != 0) {
+                out += ' ';
+                if (!fields.read_string(field)) {
+                    out += '<';
+                    append_number(out, fields.remaining());
+                    out += " bytes>";
+                    break;
+                }
+                append_escaped(out, field);
+            }
+        }
+        out += '\n';
+    }
+}
+
+std::size_t gather_records(const uint8_t* data, std::size_t size, const RecordFilter& filter,
+                           struct iovec* iov, std::size_t iov_count, std::size_t& offset) noexcept {
+    RecordReader reader(data, size);
+    reader.seek(offset);
+    
+    std::size_t used = 0;
+    std::size_t run_end = 0;  // end offset of the range in iov[used - 1]
+    std::size_t record_start = reader.offset();
+    RecordView record;
+    while (reader.next(record)) {
+        if (filter.matches(record)) {
+            const std::size_t begin = static_cast<std::size_t>(record.data - data);
+            const std::size_t end = reader.offset();
+            if (used > 0 && begin == run_end) {
+                iov[used - 1].iov_len += end - begin;
+            } else if (used < iov_count) {
+                iov[used].iov_base = const_cast<uint8_t*>(record.data);
+                iov[used].iov_len = end - begin;
+                ++used;
+            } else {
+                // Output is full; resume at this record next time
+                offset = record_start;
+                return used;
+            }
+            run_end = end;
+        }
+        record_start = reader.offset();
+    }
+    offset = size;
+    return used;
+}
+
+std::size_t gather_records(const Logger& logger, const RecordFilter& filter,
+                           struct iovec* iov, std::size_t iov_count, std::size_t& offset) noexcept {
+    return gather_records(logger.data(), logger.bytes_written(), filter, iov, iov_count, offset);
+}
+
+} // namespace log_buffer
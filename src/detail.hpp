@@ -0,0 +1,62 @@
+#pragma once
+
+// Internal helpers shared by the library's translation units; not installed.
+
+#include <cstdint>
+
+namespace log_buffer {
+namespace detail {
+
+/**
+ * @brief Round up to a power of two.
+ *
+ * @param n Value to round; 0 and 1 give 1.
+ * @return The smallest power of two not less than n.
+ */
+template <typename T>
+inline T round_up_pow2(T n) noexcept {
+    T p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+/**
+ * @brief Finalizer of splitmix64: a cheap, well-mixed 64-bit hash.
+ */
+inline uint64_t mix(uint64_t x) noexcept {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Derive count slot indexes from one hash (Kirsch-Mitzenmacher double hashing).
+ *
+ * Probe i is (h1 + i * h2) & mask, with h1 and h2 the low and high halves of
+ * the hash (h2 forced odd), so one mix() serves every row of a sketch or
+ * every bit of a Bloom filter.
+ *
+ * @param hash Well-mixed hash (see mix()).
+ * @param count Number of probes.
+ * @param mask Table size minus one (a power of two minus one).
+ * @param f Called as f(i, slot); returning false stops early.
+ * @return false if f stopped early.
+ */
+template <typename F>
+inline bool for_each_probe(uint64_t hash, uint64_t count, uint64_t mask, F&& f) {
+    const uint64_t h1 = hash & 0xFFFFFFFFu;
+    const uint64_t h2 = (hash >> 32) | 1;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!f(i, (h1 + i * h2) & mask)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+} // namespace log_buffer
@@ -0,0 +1,356 @@
+#include "log_buffer/drain.hpp"
+#include "detail.hpp"
+
+#include <utility>
+
+#if defined(__linux__)
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define LOG_BUFFER_HAVE_FUTEX 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LOG_BUFFER_HAVE_SSE2 1
+#endif
+
+namespace log_buffer {
+
+namespace {
+
+inline void cpu_relax() noexcept {
+#ifdef LOG_BUFFER_HAVE_SSE2
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+#ifdef LOG_BUFFER_HAVE_FUTEX
+void futex_wait(std::atomic<uint32_t>* word, uint32_t expected, std::chrono::nanoseconds timeout) noexcept {
+    const auto ns = timeout.count();
+    struct timespec relative;
+    relative.tv_sec = static_cast<time_t>(ns / 1000000000);
+    relative.tv_nsec = static_cast<long>(ns % 1000000000);
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE, expected, &relative, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t>* word) noexcept {
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+#endif
+
+} // namespace
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Futex word must be a plain 32-bit integer");
+
+void Notifier::notify() noexcept {
+    const uint32_t previous = m_state.fetch_or(kPending, std::memory_order_acq_rel);
+    // Only the signal that finds the consumer asleep with nothing pending wakes it
+    if (previous == kParked) {
+#ifdef LOG_BUFFER_HAVE_FUTEX
+        futex_wake(&m_state);
+#endif
+    }
+}
+
+bool Notifier::wait(std::chrono::nanoseconds timeout) noexcept {
+    for (uint32_t i = 0; i < m_spin; ++i) {
+        if (m_state.load(std::memory_order_acquire) & kPending) {
+            m_state.fetch_and(~kPending, std::memory_order_acq_rel);
+            m_spin = m_spin < kMaxSpin ? m_spin * 2 : kMaxSpin;
+            return true;
+        }
+        cpu_relax();
+    }
+    m_spin = m_spin > kMinSpin ? m_spin / 2 : kMinSpin;
+
+    uint32_t expected = 0;
+    if (!m_state.compare_exchange_strong(expected, kParked, std::memory_order_acq_rel)) {
+        // A signal arrived between the last spin and parking
+        m_state.store(0, std::memory_order_release);
+        return true;
+    }
+#ifdef LOG_BUFFER_HAVE_FUTEX
+    futex_wait(&m_state, kParked, timeout);
+#else
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (m_state.load(std::memory_order_acquire) == kParked && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+#endif
+    return (m_state.exchange(0, std::memory_order_acq_rel) & kPending) != 0;
+}
+
+BufferQueue::BufferQueue(std::size_t capacity)
+    : m_cells(new Cell[detail::round_up_pow2(capacity < 2 ? std::size_t{2} : capacity)]),
+      m_mask(detail::round_up_pow2(capacity < 2 ? std::size_t{2} : capacity) - 1), m_push_position(0),
+      m_pop_position(0) {
+    for (std::size_t i = 0; i <= m_mask; ++i) {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool BufferQueue::push(const DetachedBuffer& buffer) noexcept {
+    std::size_t position = m_push_position.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = m_cells[position & m_mask];
+        const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if (diff == 0) {
+            if (m_push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                cell.buffer = buffer;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // full
+        } else {
+            position = m_push_position.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool BufferQueue::pop(DetachedBuffer& buffer) noexcept {
+    std::size_t position = m_pop_position.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = m_cells[position & m_mask];
+        const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+        if (diff == 0) {
+            if (m_pop_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                buffer = cell.buffer;
+                cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // empty
+        } else {
+            position = m_pop_position.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+BufferPool::BufferPool(std::size_t count, std::size_t buffer_size)
+    : m_count(count), m_buffer_size(align_record(buffer_size)),
+      m_storage(new uint8_t[count * align_record(buffer_size)]), m_free(count), m_sealed(count),
+      m_release_hook(nullptr), m_release_context(nullptr) {
+    for (std::size_t i = 0; i < m_count; ++i) {
+        m_free.push(DetachedBuffer{m_storage.get() + i * m_buffer_size, 0, m_buffer_size});
+    }
+}
+
+bool BufferPool::acquire(Logger& logger) noexcept {
+    DetachedBuffer buffer;
+    if (!m_free.pop(buffer)) {
+        return false;
+    }
+    logger.attach(buffer.data, buffer.capacity);
+    return true;
+}
+
+bool BufferPool::seal(Logger& logger) noexcept {
+    const DetachedBuffer buffer = logger.detach();
+    if (buffer.data == nullptr) {
+        return false;
+    }
+    // Cannot fail: the queue holds every buffer of the pool
+    m_sealed.push(buffer);
+    m_notifier.notify();
+    return true;
+}
+
+void BufferPool::release(const DetachedBuffer& buffer) noexcept {
+    m_free.push(DetachedBuffer{buffer.data, 0, buffer.capacity});
+    if (m_release_hook != nullptr) {
+        m_release_hook(buffer, m_release_context);
+    }
+}
+
+Drainer::Drainer(BufferPool& pool, Sink sink, std::chrono::nanoseconds timeout)
+    : m_pool(pool), m_sink(std::move(sink)), m_timeout(timeout), m_running(false), m_drained(0),
+      m_sketch(nullptr), m_stats_interval(0), m_stats_buffer_size(0), m_summarizer(nullptr) {}
+
+Drainer::~Drainer() {
+    stop();
+}
+
+void Drainer::start() {
+    if (!m_running.exchange(true)) {
+        m_thread = std::thread([this] { run(); });
+    }
+}
+
+void Drainer::stop() noexcept {
+    if (m_running.exchange(false)) {
+        m_pool.notifier().notify();
+        m_thread.join();
+    }
+}
+
+std::size_t Drainer::drain() noexcept {
+    std::size_t count = 0;
+    DetachedBuffer buffer;
+    while (m_pool.pop_sealed(buffer)) {
+        if (buffer.size != 0) {
+            if (m_sketch != nullptr) {
+                m_sketch->add_buffer(buffer.data, buffer.size);
+            }
+            if (m_summarizer != nullptr) {
+                m_summarizer->summarize(buffer.data, buffer.size);
+                m_sink(m_summarizer->data(), m_summarizer->size());
+            }
+            m_sink(buffer.data, buffer.size);
+        }
+        m_pool.release(buffer);
+        ++count;
+    }
+    m_drained.fetch_add(count, std::memory_order_relaxed);
+    if (m_sketch != nullptr && std::chrono::steady_clock::now() >= m_next_stats) {
+        emit_site_stats();
+    }
+    return count;
+}
+
+void Drainer::set_site_sketch(SiteSketch* sketch, std::chrono::nanoseconds interval) {
+    m_sketch = sketch;
+    m_stats_interval = interval;
+    m_next_stats = std::chrono::steady_clock::now() + interval;
+    if (sketch != nullptr) {
+        m_stats_buffer_size = align_record(sizeof(RecordHeader) + sketch->max_payload_size());
+        m_stats_buffer.reset(new uint8_t[m_stats_buffer_size]);
+    }
+}
+
+void Drainer::emit_site_stats() noexcept {
+    m_next_stats = std::chrono::steady_clock::now() + m_stats_interval;
+    if (m_sketch->total() == 0) {
+        return;
+    }
+    Logger logger(m_stats_buffer.get(), m_stats_buffer_size);
+    if (m_sketch->emit(logger)) {
+        m_sink(logger.data(), logger.bytes_written());
+    }
+    m_sketch->clear();
+}
+
+void Drainer::run() noexcept {
+    while (m_running.load(std::memory_order_acquire)) {
+        drain();
+        m_pool.notifier().wait(m_timeout);
+    }
+    drain();
+    if (m_sketch != nullptr) {
+        emit_site_stats();
+    }
+}
+
+FormatDrainer::FormatDrainer(BufferPool& pool, std::size_t threads, Formatter format, Writer write,
+                             std::chrono::nanoseconds timeout)
+    : m_pool(pool), m_format(std::move(format)), m_write(std::move(write)), m_timeout(timeout),
+      m_slots(pool.count()), m_next_ticket(0), m_next_write(0), m_writing(false), m_stopping(false),
+      m_running(false), m_written(0), m_thread_count(threads < 1 ? 1 : threads) {}
+
+FormatDrainer::~FormatDrainer() {
+    stop();
+}
+
+void FormatDrainer::start() {
+    if (m_running.exchange(true)) {
+        return;
+    }
+    m_stopping = false;
+    for (std::size_t i = 0; i < m_thread_count; ++i) {
+        m_formatters.emplace_back([this] { format(); });
+    }
+    m_dispatcher = std::thread([this] { dispatch(); });
+}
+
+void FormatDrainer::stop() noexcept {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    m_pool.notifier().notify();
+    m_dispatcher.join();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_job_ready.notify_all();
+    for (auto& formatter : m_formatters) {
+        formatter.join();
+    }
+    m_formatters.clear();
+}
+
+void FormatDrainer::dispatch() noexcept {
+    const auto queue_sealed = [this] {
+        DetachedBuffer buffer;
+        while (m_pool.pop_sealed(buffer)) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            // Backpressure: ticket t needs slot t % size, free once t - size was written
+            m_slot_free.wait(lock, [&] { return m_next_ticket - m_next_write < m_slots.size(); });
+            m_jobs.push_back(Job{buffer, m_next_ticket++});
+            lock.unlock();
+            m_job_ready.notify_one();
+        }
+    };
+    while (m_running.load(std::memory_order_acquire)) {
+        queue_sealed();
+        m_pool.notifier().wait(m_timeout);
+    }
+    queue_sealed();
+}
+
+void FormatDrainer::format() noexcept {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_job_ready.wait(lock, [&] { return !m_jobs.empty() || m_stopping; });
+        if (m_jobs.empty()) {
+            return; // stopping and nothing left
+        }
+        const Job job = m_jobs.front();
+        m_jobs.pop_front();
+        Slot& slot = m_slots[job.ticket % m_slots.size()];
+        lock.unlock();
+
+        // The slot belongs to this ticket until it is written, so no lock is needed
+        slot.text.clear();
+        if (job.buffer.size != 0) {
+            m_format(job.buffer.data, job.buffer.size, slot.text);
+        }
+        m_pool.release(job.buffer);
+
+        lock.lock();
+        slot.ready = true;
+        write_ready(lock);
+    }
+}
+
+void FormatDrainer::write_ready(std::unique_lock<std::mutex>& lock) noexcept {
+    if (m_writing) {
+        return; // the current writer will pick this slot up
+    }
+    m_writing = true;
+    for (;;) {
+        Slot& slot = m_slots[m_next_write % m_slots.size()];
+        if (!slot.ready) {
+            break;
+        }
+        lock.unlock();
+        if (!slot.text.empty()) {
+            m_write(slot.text.data(), slot.text.size());
+        }
+        lock.lock();
+        slot.ready = false;
+        ++m_next_write;
+        m_written.fetch_add(1, std::memory_order_relaxed);
+        m_slot_free.notify_one();
+    }
+    m_writing = false;
+}
+
+} // namespace log_buffer
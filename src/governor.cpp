@@ -0,0 +1,65 @@
+#include "log_buffer/governor.hpp"
+#include "detail.hpp"
+
+namespace log_buffer {
+
+Governor::Governor(const GovernorConfig& config) noexcept
+    : m_config(config),
+      m_timing_mask(detail::round_up_pow2(uint64_t{config.sample_every == 0 ? 1 : config.sample_every}) - 1),
+      m_calls(0), m_sample_counter(0), m_sample_mask(0), m_sampling_shift(0), m_floor(Level::Trace), m_shed(0),
+      m_sampled_cycles(0), m_interval_start(read_cycles()),
+      m_interval_end(std::chrono::steady_clock::now() + config.interval), m_load(0) {
+    m_config.sample_every = static_cast<uint32_t>(m_timing_mask + 1);
+    if (m_config.interval < std::chrono::nanoseconds(1)) {
+        m_config.interval = std::chrono::nanoseconds(1);
+        m_interval_end = std::chrono::steady_clock::now() + m_config.interval;
+    }
+    if (m_config.max_sampling_shift > 63) {
+        m_config.max_sampling_shift = 63;
+    }
+}
+
+void Governor::sample_taken() noexcept {
+    const auto now = std::chrono::steady_clock::now();
+    if (now < m_interval_end) {
+        return;
+    }
+    const uint64_t cycles = read_cycles();
+    const uint64_t elapsed = cycles - m_interval_start;
+    const double busy = static_cast<double>(m_sampled_cycles) * static_cast<double>(m_config.sample_every);
+    const double load = elapsed != 0 ? busy / static_cast<double>(elapsed) : 0;
+    // After a quiet spell with no sampled calls, relax once per interval that passed
+    const auto intervals = 1 + (now - m_interval_end) / m_config.interval;
+    update(load);
+    for (auto i = intervals; i > 1 && load < m_config.budget * m_config.relax_below; --i) {
+        if (m_floor == Level::Trace && m_sampling_shift == 0) {
+            break;
+        }
+        update(load);
+    }
+    m_sampled_cycles = 0;
+    m_interval_start = cycles;
+    m_interval_end = now + m_config.interval;
+}
+
+void Governor::update(double load) noexcept {
+    m_load = load;
+    if (load > m_config.budget) {
+        // Escalate: sample harder first, then raise the floor
+        if (m_sampling_shift < m_config.max_sampling_shift) {
+            ++m_sampling_shift;
+        } else if (m_floor < m_config.protected_level) {
+            m_floor = static_cast<Level>(static_cast<uint8_t>(m_floor) + 1);
+        }
+    } else if (load < m_config.budget * m_config.relax_below) {
+        // Relax in reverse order
+        if (m_floor > Level::Trace) {
+            m_floor = static_cast<Level>(static_cast<uint8_t>(m_floor) - 1);
+        } else if (m_sampling_shift > 0) {
+            --m_sampling_shift;
+        }
+    }
+    apply_sampling();
+}
+
+} // namespace log_buffer
@@ -0,0 +1,161 @@
+#include "log_buffer/level_table.hpp"
+
+#include <new>
+#include <thread>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LOG_BUFFER_HAVE_SHM 1
+#endif
+
+namespace log_buffer {
+
+static_assert(std::atomic<uint8_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "Level bitmaps and the magic must be lock-free to live in shared memory");
+
+namespace {
+
+void initialize(LevelControlBlock* block) noexcept {
+    for (auto& mask : block->levels) {
+        mask.store(kDefaultLevelMask, std::memory_order_relaxed);
+    }
+    block->version = kLevelTableVersion;
+    // Publish the magic last so attachers never see a half-initialized table
+    block->magic.store(kLevelTableMagic, std::memory_order_release);
+}
+
+#ifdef LOG_BUFFER_HAVE_SHM
+/// Poll interval while waiting for a table another process is creating
+constexpr std::chrono::milliseconds kAttachPoll{1};
+#endif
+
+} // namespace
+
+LevelTable::~LevelTable() {
+    close();
+}
+
+LevelTable::LevelTable(LevelTable&& other) noexcept
+    : m_block(std::exchange(other.m_block, nullptr)), m_shared(other.m_shared) {}
+
+LevelTable& LevelTable::operator=(LevelTable&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_block = std::exchange(other.m_block, nullptr);
+        m_shared = other.m_shared;
+    }
+    return *this;
+}
+
+bool LevelTable::open(const char* name, bool create) noexcept {
+#ifdef LOG_BUFFER_HAVE_SHM
+    close();
+    
+    bool created = false;
+    int fd = -1;
+    if (create) {
+        fd = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0666);
+        created = fd >= 0;
+    }
+    if (fd < 0 && (!create || errno == EEXIST)) {
+        fd = ::shm_open(name, O_RDWR, 0);
+    }
+    if (fd < 0) {
+        return false;
+    }
+    if (created && ::ftruncate(fd, sizeof(LevelControlBlock)) != 0) {
+        ::close(fd);
+        ::shm_unlink(name);
+        return false;
+    }
+    
+    // The creator may not have sized the object yet: size 0 means wait, not fail
+    const auto deadline = std::chrono::steady_clock::now() + kLevelTableAttachTimeout;
+    struct stat info;
+    while (::fstat(fd, &info) == 0 && info.st_size == 0 && !created
+           && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(kAttachPoll);
+    }
+    if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(LevelControlBlock)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = ::mmap(nullptr, sizeof(LevelControlBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    
+    auto* block = static_cast<LevelControlBlock*>(mapping);
+    if (created) {
+        initialize(block);
+    } else {
+        // Likewise for the magic, which the creator publishes last
+        uint32_t magic = block->magic.load(std::memory_order_acquire);
+        while (magic == 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(kAttachPoll);
+            magic = block->magic.load(std::memory_order_acquire);
+        }
+        if (magic != kLevelTableMagic || block->version != kLevelTableVersion) {
+            ::munmap(mapping, sizeof(LevelControlBlock));
+            return false;
+        }
+    }
+    m_block = block;
+    m_shared = true;
+    return true;
+#else
+    (void)name;
+    (void)create;
+    return false;
+#endif
+}
+
+bool LevelTable::open_local() noexcept {
+    close();
+    auto* block = new (std::nothrow) LevelControlBlock;
+    if (block == nullptr) {
+        return false;
+    }
+    initialize(block);
+    m_block = block;
+    m_shared = false;
+    return true;
+}
+
+void LevelTable::close() noexcept {
+    if (m_block == nullptr) {
+        return;
+    }
+#ifdef LOG_BUFFER_HAVE_SHM
+    if (m_shared) {
+        ::munmap(m_block, sizeof(LevelControlBlock));
+        m_block = nullptr;
+        return;
+    }
+#endif
+    delete m_block;
+    m_block = nullptr;
+}
+
+bool LevelTable::remove(const char* name) noexcept {
+#ifdef LOG_BUFFER_HAVE_SHM
+    return ::shm_unlink(name) == 0;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+void LevelTable::set_all(uint8_t mask) noexcept {
+    for (auto& levels : m_block->levels) {
+        levels.store(mask, std::memory_order_relaxed);
+    }
+}
+
+} // namespace log_buffer
@@ -1,29 +1,506 @@
 #include "log_buffer/logger.hpp"
+#include "log_buffer/drain.hpp"
+#include "log_buffer/site_sketch.hpp"
+
+#include <chrono>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LOG_BUFFER_HAVE_SSE2 1
+#endif
 
 namespace log_buffer {
 
+namespace {
+
+constexpr char32_t kReplacementChar = 0xFFFD;
+
+inline bool is_high_surrogate(char32_t c) noexcept { return c >= 0xD800 && c <= 0xDBFF; }
+inline bool is_low_surrogate(char32_t c) noexcept { return c >= 0xDC00 && c <= 0xDFFF; }
+
+inline uint8_t* encode_utf8(uint8_t* out, char32_t c) noexcept {
+    if (c < 0x80) {
+        *out++ = static_cast<uint8_t>(c);
+    } else if (c < 0x800) {
+        *out++ = static_cast<uint8_t>(0xC0 | (c >> 6));
+        *out++ = static_cast<uint8_t>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        *out++ = static_cast<uint8_t>(0xE0 | (c >> 12));
+        *out++ = static_cast<uint8_t>(0x80 | ((c >> 6) & 0x3F));
+        *out++ = static_cast<uint8_t>(0x80 | (c & 0x3F));
+    } else {
+        *out++ = static_cast<uint8_t>(0xF0 | (c >> 18));
+        *out++ = static_cast<uint8_t>(0x80 | ((c >> 12) & 0x3F));
+        *out++ = static_cast<uint8_t>(0x80 | ((c >> 6) & 0x3F));
+        *out++ = static_cast<uint8_t>(0x80 | (c & 0x3F));
+    }
+    return out;
+}
+
+inline std::size_t utf8_size(char32_t c) noexcept {
+    return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+}
+
+// Decode one code point starting at src[i] and advance i past it
+inline char32_t next_code_point(const char16_t* src, std::size_t length, std::size_t& i) noexcept {
+    const char32_t c = src[i++];
+    if (!is_high_surrogate(c) && !is_low_surrogate(c)) {
+        return c;
+    }
+    if (is_high_surrogate(c) && i < length && is_low_surrogate(src[i])) {
+        const char32_t low = src[i++];
+        return 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+    }
+    return kReplacementChar;
+}
+
+inline char32_t next_code_point(const char32_t* src, std::size_t /*length*/, std::size_t& i) noexcept {
+    const char32_t c = src[i++];
+    return (c > 0x10FFFF || is_high_surrogate(c) || is_low_surrogate(c)) ? kReplacementChar : c;
+}
+
+// Copy a run of ASCII code units 8 at a time; returns the number of units consumed
+inline std::size_t copy_ascii_block(const char16_t* src, std::size_t length, uint8_t* out) noexcept {
+    std::size_t i = 0;
+#ifdef LOG_BUFFER_HAVE_SSE2
+    const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+    for (; i + 8 <= length; i += 8) {
+        const __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, non_ascii), _mm_setzero_si128())) != 0xFFFF) {
+            break;
+        }
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(units, units));
+    }
+#endif
+    for (; i < length && src[i] < 0x80; ++i) {
+        out[i] = static_cast<uint8_t>(src[i]);
+    }
+    return i;
+}
+
+inline std::size_t copy_ascii_block(const char32_t* src, std::size_t length, uint8_t* out) noexcept {
+    std::size_t i = 0;
+#ifdef LOG_BUFFER_HAVE_SSE2
+    const __m128i non_ascii = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+    for (; i + 8 <= length; i += 8) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+        const __m128i any = _mm_and_si128(_mm_or_si128(lo, hi), non_ascii);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(any, _mm_setzero_si128())) != 0xFFFF) {
+            break;
+        }
+        const __m128i words = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(words, words));
+    }
+#endif
+    for (; i < length && src[i] < 0x80; ++i) {
+        out[i] = static_cast<uint8_t>(src[i]);
+    }
+    return i;
+}
+
+// Bulk copy that bypasses the cache for large ranges
+void copy_bytes(uint8_t* dst, const uint8_t* src, std::size_t size) noexcept {
+#ifdef LOG_BUFFER_HAVE_SSE2
+    if (size >= kStreamingCopyThreshold) {
+        // Align the destination, stream whole 64-byte chunks, then copy the tail
+        const std::size_t head = (16 - (reinterpret_cast<std::uintptr_t>(dst) & 15)) & 15;
+        std::memcpy(dst, src, head);
+        dst += head;
+        src += head;
+        size -= head;
+        for (; size >= 64; size -= 64, dst += 64, src += 64) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dst), a);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), b);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), d);
+        }
+        _mm_sfence();
+    }
+#endif
+    std::memcpy(dst, src, size);
+}
+
+template<typename CharT>
+uint8_t* transcode_utf8(const CharT* src, std::size_t length, uint8_t* out) noexcept {
+    std::size_t i = 0;
+    while (i < length) {
+        const std::size_t ascii = copy_ascii_block(src + i, length - i, out);
+        i += ascii;
+        out += ascii;
+        if (i < length) {
+            out = encode_utf8(out, next_code_point(src, length, i));
+        }
+    }
+    return out;
+}
+
+template<typename CharT>
+std::size_t transcoded_size(const CharT* src, std::size_t length) noexcept {
+    std::size_t size = 0;
+    std::size_t i = 0;
+    while (i < length) {
+        size += utf8_size(next_code_point(src, length, i));
+    }
+    return size;
+}
+
+// Shift the metadata timestamps of the records in [data, data + size) by delta_us, saturating
+void rebase_timestamps(uint8_t* data, std::size_t size, int64_t delta_us) noexcept {
+    std::size_t offset = 0;
+    while (offset + sizeof(RecordHeader) <= size) {
+        RecordHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+        if (header.size == 0) {
+            offset += kRecordAlignment;
+            continue;
+        }
+        if (header.size == kBufferMagic || header.size < sizeof(RecordHeader) || header.size > size - offset) {
+            return; // a nested buffer brings its own epoch; anything else is not a record
+        }
+        if ((header.type & kRecordFlagMetadata) && header.size >= sizeof(RecordHeader) + sizeof(RecordMetadata)) {
+            uint8_t* field = data + offset + sizeof(RecordHeader) + offsetof(RecordMetadata, timestamp_us);
+            uint32_t timestamp_us;
+            std::memcpy(&timestamp_us, field, sizeof(timestamp_us));
+            if (timestamp_us != kTimestampSaturated) {
+                const int64_t shifted = int64_t{timestamp_us} + delta_us;
+                timestamp_us = shifted <= 0 ? 0
+                             : shifted >= int64_t{kTimestampSaturated} ? kTimestampSaturated
+                             : static_cast<uint32_t>(shifted);
+                std::memcpy(field, &timestamp_us, sizeof(timestamp_us));
+            }
+        }
+        offset += align_record(header.size);
+    }
+}
+
+uint64_t steady_now_ns() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+Logger::Logger(Logger&& other) noexcept
+    : Logger(nullptr, 0) {
+    swap(other);
+}
+
+Logger& Logger::operator=(Logger&& other) noexcept {
+    if (this != &other) {
+        Logger taken(std::move(other));
+        swap(taken);
+    }
+    return *this;
+}
+
+void Logger::swap(Logger& other) noexcept {
+    std::swap(m_buffer, other.m_buffer);
+    std::swap(m_capacity, other.m_capacity);
+    std::swap(m_position, other.m_position);
+    std::swap(m_overflow, other.m_overflow);
+    std::swap(m_int_format, other.m_int_format);
+    std::swap(m_string_format, other.m_string_format);
+    std::swap(m_max_field_length, other.m_max_field_length);
+    std::swap(m_record_start, other.m_record_start);
+    std::swap(m_record_failed, other.m_record_failed);
+    std::swap(m_parent, other.m_parent);
+    std::swap(m_gap_records, other.m_gap_records);
+    std::swap(m_dropped_records, other.m_dropped_records);
+    std::swap(m_dropped_bytes, other.m_dropped_bytes);
+    std::swap(m_sequence_numbers, other.m_sequence_numbers);
+    std::swap(m_have_sequence_base, other.m_have_sequence_base);
+    std::swap(m_next_sequence, other.m_next_sequence);
+    std::swap(m_last_sequence, other.m_last_sequence);
+    std::swap(m_buffer_header, other.m_buffer_header);
+    std::swap(m_header_size, other.m_header_size);
+    std::swap(m_epoch, other.m_epoch);
+    std::swap(m_format_hash, other.m_format_hash);
+    std::swap(m_record_metadata, other.m_record_metadata);
+    std::swap(m_epoch_ns, other.m_epoch_ns);
+    std::swap(m_notifier, other.m_notifier);
+    std::swap(m_notify_threshold, other.m_notify_threshold);
+    std::swap(m_notify_armed, other.m_notify_armed);
+    std::swap(m_high_watermark, other.m_high_watermark);
+    std::swap(m_low_watermark, other.m_low_watermark);
+    std::swap(m_watermark_hook, other.m_watermark_hook);
+    std::swap(m_watermark_context, other.m_watermark_context);
+    std::swap(m_above_high, other.m_above_high);
+    std::swap(m_signal_position, other.m_signal_position);
+    std::swap(m_drop_sketch, other.m_drop_sketch);
+    std::swap(m_record_key, other.m_record_key);
+}
+
+void Logger::reset() noexcept {
+    m_position = 0;
+    m_overflow = false;
+    m_record_start = kNoRecord;
+    m_have_sequence_base = false;
+    m_header_size = 0;
+    m_notify_armed = m_notifier != nullptr;
+    if (m_buffer_header || m_record_metadata) {
+        m_epoch_ns = steady_now_ns();
+    }
+    if (m_buffer_header) {
+        write_buffer_header();
+    }
+    check_low_watermark();
+    update_signal_position();
+    if (m_gap_records && m_dropped_records != 0) {
+        write_gap_record();
+    }
+}
+
+Logger& Logger::set_buffer_header(bool enable) noexcept {
+    m_buffer_header = enable;
+    if (enable && m_position == 0) {
+        m_epoch_ns = steady_now_ns();
+        write_buffer_header();
+    }
+    return *this;
+}
+
+Logger& Logger::set_record_metadata(bool enable) noexcept {
+    if (enable && !m_record_metadata && m_header_size == 0) {
+        m_epoch_ns = steady_now_ns();
+    }
+    m_record_metadata = enable;
+    return *this;
+}
+
+Logger& Logger::set_notifier(Notifier* notifier, std::size_t threshold) noexcept {
+    m_notifier = notifier;
+    m_notify_threshold = notifier != nullptr ? threshold : kNoSignal;
+    m_notify_armed = notifier != nullptr;
+    update_signal_position();
+    if (m_position >= m_signal_position) {
+        signal_threshold();
+    }
+    return *this;
+}
+
+Logger& Logger::set_watermarks(std::size_t high, std::size_t low, WatermarkHook hook, void* context) noexcept {
+    m_high_watermark = high;
+    m_low_watermark = low < high ? low : high;
+    m_watermark_hook = hook;
+    m_watermark_context = context;
+    update_signal_position();
+    if (m_position >= m_signal_position) {
+        signal_threshold();
+    }
+    return *this;
+}
+
+void Logger::signal_threshold() noexcept {
+    // Both signals are edge-triggered: disarm before calling out
+    const bool notify = m_notify_armed && m_position >= m_notify_threshold;
+    const bool high = !m_above_high && m_position >= m_high_watermark;
+    if (notify) {
+        m_notify_armed = false;
+    }
+    if (high) {
+        m_above_high = true;
+    }
+    update_signal_position();
+    if (notify) {
+        m_notifier->notify();
+    }
+    if (high && m_watermark_hook != nullptr) {
+        m_watermark_hook(*this, true, m_watermark_context);
+    }
+}
+
+void Logger::check_low_watermark() noexcept {
+    if (m_above_high && m_position < m_low_watermark) {
+        m_above_high = false;
+        update_signal_position();
+        if (m_watermark_hook != nullptr) {
+            m_watermark_hook(*this, false, m_watermark_context);
+        }
+    }
+}
+
+RecordMetadata Logger::make_metadata(uint32_t site) const noexcept {
+    const uint64_t elapsed_us = (steady_now_ns() - m_epoch_ns) / 1000;
+    return RecordMetadata{site, elapsed_us < kTimestampSaturated ? static_cast<uint32_t>(elapsed_us)
+                                                                 : kTimestampSaturated};
+}
+
+void Logger::write_buffer_header() noexcept {
+    if (sizeof(BufferHeader) > m_capacity) {
+        return;
+    }
+    BufferHeader header{};
+    header.magic = kBufferMagic;
+    header.version = kBufferFormatVersion;
+    header.header_size = sizeof(BufferHeader);
+#if defined(__linux__)
+    header.pid = static_cast<uint32_t>(::getpid());
+    header.tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+    ::prctl(PR_GET_NAME, header.thread_name, 0, 0, 0);
+#elif defined(__unix__) || defined(__APPLE__)
+    header.pid = static_cast<uint32_t>(::getpid());
+    ::pthread_getname_np(::pthread_self(), header.thread_name, sizeof(header.thread_name));
+#endif
+    header.thread_name[sizeof(header.thread_name) - 1] = '\0';
+    header.steady_ns = m_epoch_ns;
+    header.system_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    header.format_hash = m_format_hash;
+    header.first_sequence = m_next_sequence;
+    header.epoch = m_epoch++;
+    
+    std::memcpy(m_buffer, &header, sizeof(header));
+    m_position = sizeof(header);
+    m_header_size = sizeof(header);
+}
+
+DetachedBuffer Logger::detach() noexcept {
+    if (m_record_start != kNoRecord) {
+        drop_record(m_record_start);
+    }
+    const DetachedBuffer detached{m_buffer, m_position, m_capacity};
+    attach(nullptr, 0);
+    return detached;
+}
+
+void Logger::attach(uint8_t* buffer, std::size_t size) noexcept {
+    m_buffer = buffer;
+    m_capacity = size;
+    m_parent = nullptr;
+    reset();
+}
+
+Logger Logger::child(std::size_t n) noexcept {
+    const std::size_t start = align_record(m_position);
+    const std::size_t size = align_record(n);
+    // A child carved inside an open record would end up as that record's payload
+    if (m_record_start != kNoRecord || start > m_capacity || size > m_capacity - start || size < n) {
+        mark_overflow(n);
+        Logger empty(nullptr, 0);
+        empty.m_int_format = m_int_format;
+        empty.m_string_format = m_string_format;
+        empty.m_max_field_length = m_max_field_length;
+        return empty;
+    }
+    std::memset(m_buffer + m_position, 0, start - m_position);
+    m_position = start + size;
+    // The child's records sit between ours, so our next one restates its sequence
+    m_have_sequence_base = false;
+    
+    Logger carved(m_buffer + start, size);
+    carved.m_int_format = m_int_format;
+    carved.m_string_format = m_string_format;
+    carved.m_max_field_length = m_max_field_length;
+    carved.m_sequence_numbers = m_sequence_numbers;
+    carved.m_record_metadata = m_record_metadata;
+    carved.m_epoch_ns = m_epoch_ns;  // timestamps stay relative to the parent's epoch
+    carved.m_parent = this;
+    return carved;
+}
+
+bool Logger::close() noexcept {
+    if (m_parent == nullptr) {
+        return false;
+    }
+    if (m_record_start != kNoRecord) {
+        m_position = m_record_start;
+        m_record_start = kNoRecord;
+    }
+    
+    const std::size_t offset = static_cast<std::size_t>(m_buffer - m_parent->m_buffer);
+    const std::size_t used = align_record(m_position);
+    if (m_parent->m_position == offset + m_capacity) {
+        // Last reservation in the parent: hand the tail back
+        std::memset(m_buffer + m_position, 0, used - m_position);
+        m_parent->m_position = offset + used;
+        m_parent->check_low_watermark();
+    } else {
+        std::memset(m_buffer + m_position, 0, m_capacity - m_position);
+    }
+    attach(nullptr, 0);
+    return true;
+}
+
 bool Logger::log(const uint8_t* data, std::size_t size) noexcept {
     if (size > remaining_capacity()) {
-        m_overflow = true;
+        mark_overflow(size);
         return false;
     }
     std::memcpy(m_buffer + m_position, data, size);
-    m_position += size;
+    advance(size);
     return true;
 }
 
-bool Logger::log(std::string_view str) noexcept {
-    const std::size_t total_size = str.size() + 1; // +1 for null terminator
-    if (total_size > remaining_capacity()) {
-        m_overflow = true;
+bool Logger::append(const Logger& other) noexcept {
+    const std::size_t size = other.m_record_start != kNoRecord ? other.m_record_start : other.m_position;
+    uint8_t* copied = m_buffer + m_position;
+    if (!append_range(other.m_buffer + other.m_header_size, other.m_buffer + size)) {
+        return false;
+    }
+    // The copied timestamps count from the other logger's epoch: restate them against ours
+    if (other.m_record_metadata && other.m_epoch_ns != m_epoch_ns && (m_header_size != 0 || m_record_metadata)) {
+        rebase_timestamps(copied, size - other.m_header_size,
+                          static_cast<int64_t>(other.m_epoch_ns - m_epoch_ns) / 1000);
+    }
+    return true;
+}
+
+bool Logger::append_range(const uint8_t* begin, const uint8_t* end) noexcept {
+    const std::size_t size = static_cast<std::size_t>(end - begin);
+    if (size > remaining_capacity()) {
+        mark_overflow(size);
         return false;
     }
-    std::memcpy(m_buffer + m_position, str.data(), str.size());
-    m_buffer[m_position + str.size()] = '\0';
-    m_position += total_size;
+    if (size != 0) {
+        copy_bytes(m_buffer + m_position, begin, size);
+        // Copied records may carry another producer's sequence numbers
+        m_have_sequence_base = false;
+    }
+    advance(size);
     return true;
 }
 
+bool Logger::log(std::string_view str) noexcept {
+    if (str.size() > m_max_field_length) {
+        return log(str, m_max_field_length);
+    }
+    return log_formatted_string(str.data(), str.size());
+}
+
+bool Logger::log(std::string_view str, std::size_t max_len) noexcept {
+    if (str.size() <= max_len) {
+        return log_formatted_string(str.data(), str.size());
+    }
+    return log_formatted_string(str.data(), max_len, kTruncationMarker);
+}
+
+bool Logger::log(const char* str) noexcept {
+    if (m_max_field_length == kNoFieldLimit) {
+        return log(std::string_view(str));
+    }
+    // Only look one byte past the limit: that is enough to know whether to truncate
+    const void* nul = std::memchr(str, '\0', m_max_field_length + 1);
+    if (nul == nullptr) {
+        return log_formatted_string(str, m_max_field_length, kTruncationMarker);
+    }
+    return log_formatted_string(str, static_cast<const char*>(nul) - str);
+}
+
 Logger& Logger::operator<<(std::ios_base& (*manip)(std::ios_base&)) noexcept {
     // Detect which manipulator by calling it on a test stream and checking flags
     
@@ -70,18 +547,215 @@ Logger& Logger::operator<<(std::ios_base& (*manip)(std::ios_base&)) noexcept {
     return *this;
 }
 
-bool Logger::log_formatted_string(const char* str, std::size_t length) noexcept {
-    const std::size_t total_size = length + 1; // +1 for null terminator
+bool Logger::log_formatted_string(const char* str, std::size_t length, std::string_view suffix) noexcept {
+    const std::size_t field_length = length + suffix.size();
+    if (m_string_format == StringFormat::LengthPrefixed) {
+        const std::size_t total_size = varint_size(field_length) + field_length;
+        if (total_size > remaining_capacity()) {
+            mark_overflow(total_size);
+            return false;
+        }
+        uint8_t* out = encode_varint(m_buffer + m_position, field_length);
+        std::memcpy(out, str, length);
+        if (!suffix.empty()) {
+            std::memcpy(out + length, suffix.data(), suffix.size());
+        }
+        advance(total_size);
+        return true;
+    }
+
+    const std::size_t total_size = field_length + 1; // +1 for null terminator
     
     if (total_size > remaining_capacity()) {
-        m_overflow = true;
+        mark_overflow(total_size);
         return false;
     }
     
-    std::memcpy(m_buffer + m_position, str, length);
-    m_buffer[m_position + length] = '\0';
-    m_position += total_size;
+    uint8_t* out = m_buffer + m_position;
+    std::memcpy(out, str, length);
+    if (!suffix.empty()) {
+        std::memcpy(out + length, suffix.data(), suffix.size());
+    }
+    out[field_length] = '\0';
+    advance(total_size);
     return true;
 }
 
+template<typename CharT>
+bool Logger::log_unicode(const CharT* str, std::size_t length) noexcept {
+    const bool prefixed = m_string_format == StringFormat::LengthPrefixed;
+    
+    // Worst case first, so the common path never walks the input twice
+    std::size_t field_length = length * (sizeof(CharT) == sizeof(char16_t) ? 3 : 4);
+    std::size_t overhead = prefixed ? varint_size(field_length) : 1;
+    if (field_length + overhead > remaining_capacity()) {
+        field_length = transcoded_size(str, length);
+        overhead = prefixed ? varint_size(field_length) : 1;
+        if (field_length + overhead > remaining_capacity()) {
+            mark_overflow(field_length + overhead);
+            return false;
+        }
+    }
+    
+    uint8_t* out = m_buffer + m_position;
+    if (prefixed) {
+        // The prefix width was reserved from the bound; pad the actual length to fit it
+        uint8_t* end = transcode_utf8(str, length, out + overhead);
+        encode_varint_padded(out, static_cast<uint64_t>(end - (out + overhead)), overhead);
+        advance(static_cast<std::size_t>(end - out));
+    } else {
+        uint8_t* end = transcode_utf8(str, length, out);
+        *end = '\0';
+        advance(static_cast<std::size_t>(end + 1 - out));
+    }
+    return true;
+}
+
+bool Logger::begin_record(Level level, uint16_t tag, uint32_t site) noexcept {
+    if (m_record_start != kNoRecord) {
+        return false; // records do not nest
+    }
+    m_record_key = m_record_metadata ? site : tag;
+    
+    // Every attempt consumes a sequence number, so dropped records show up as gaps
+    uint8_t type = static_cast<uint8_t>(RecordType::Log);
+    uint64_t sequence_field = 0;
+    std::size_t header_size = sizeof(RecordHeader);
+    if (m_record_metadata) {
+        type |= kRecordFlagMetadata;
+        header_size += sizeof(RecordMetadata);
+    }
+    if (m_sequence_numbers) {
+        const uint64_t sequence = m_next_sequence++;
+        if (m_have_sequence_base) {
+            type |= kRecordFlagSequence;
+            sequence_field = sequence - m_last_sequence;
+        } else {
+            type |= kRecordFlagSequence | kRecordFlagSequenceBase;
+            sequence_field = sequence;
+        }
+        header_size += varint_size(sequence_field);
+    }
+    
+    const std::size_t start = align_record(m_position);
+    if (start + header_size > m_capacity) {
+        // Keep the record open so end_record() pairs up and discards it
+        m_record_start = m_position;
+        mark_overflow(header_size);
+        return false;
+    }
+    std::memset(m_buffer + m_position, 0, start - m_position);
+    
+    // Size is patched in by end_record(); zero marks the slot as padding meanwhile
+    const RecordHeader header{0, type, static_cast<uint8_t>(level), tag};
+    std::memcpy(m_buffer + start, &header, sizeof(header));
+    uint8_t* out = m_buffer + start + sizeof(header);
+    if (type & kRecordFlagMetadata) {
+        const RecordMetadata metadata = make_metadata(site);
+        std::memcpy(out, &metadata, sizeof(metadata));
+        out += sizeof(metadata);
+    }
+    if (type & kRecordFlagSequence) {
+        encode_varint(out, sequence_field);
+    }
+    m_record_start = start;
+    m_record_failed = false;
+    m_position = start + header_size;
+    if (m_position >= m_signal_position) {
+        signal_threshold();
+    }
+    return true;
+}
+
+bool Logger::end_record() noexcept {
+    if (m_record_start == kNoRecord) {
+        return false;
+    }
+    const std::size_t start = m_record_start;
+    m_record_start = kNoRecord;
+    
+    const std::size_t size = m_position - start;
+    if (m_record_failed || size > UINT32_MAX) {
+        // Drop the whole record rather than leave a partial one in the stream
+        drop_record(start);
+        return false;
+    }
+    const uint32_t record_size = static_cast<uint32_t>(size);
+    std::memcpy(m_buffer + start + offsetof(RecordHeader, size), &record_size, sizeof(record_size));
+    if (m_buffer[start + offsetof(RecordHeader, type)] & kRecordFlagSequence) {
+        // Later records in this buffer are encoded relative to this one
+        m_last_sequence = m_next_sequence - 1;
+        m_have_sequence_base = true;
+    }
+    
+    const std::size_t end = align_record(m_position);
+    if (end <= m_capacity) {
+        std::memset(m_buffer + m_position, 0, end - m_position);
+        advance(end - m_position);
+    }
+    return true;
+}
+
+void Logger::drop_record(std::size_t start) noexcept {
+    ++m_dropped_records;
+    m_dropped_bytes += m_position - start;
+    m_position = start;
+    m_record_start = kNoRecord;
+    if (m_drop_sketch != nullptr) {
+        m_drop_sketch->add(m_record_key);
+    }
+    check_low_watermark();
+}
+
+bool Logger::write_record(RecordType type, Level level, uint16_t tag,
+                          const uint8_t* payload, std::size_t size) noexcept {
+    const std::size_t start = align_record(m_position);
+    const std::size_t prefix_size = sizeof(RecordHeader) + (m_record_metadata ? sizeof(RecordMetadata) : 0);
+    const std::size_t record_size = prefix_size + size;
+    if (start > m_capacity || record_size > m_capacity - start) {
+        return false;
+    }
+    std::memset(m_buffer + m_position, 0, start - m_position);
+    
+    const uint8_t flags = m_record_metadata ? kRecordFlagMetadata : 0;
+    const RecordHeader header{static_cast<uint32_t>(record_size), static_cast<uint8_t>(static_cast<uint8_t>(type) | flags),
+                              static_cast<uint8_t>(level), tag};
+    std::memcpy(m_buffer + start, &header, sizeof(header));
+    if (m_record_metadata) {
+        const RecordMetadata metadata = make_metadata(0);
+        std::memcpy(m_buffer + start + sizeof(header), &metadata, sizeof(metadata));
+    }
+    std::memcpy(m_buffer + start + prefix_size, payload, size);
+    m_position = start + record_size;
+    
+    const std::size_t end = align_record(m_position);
+    if (end <= m_capacity) {
+        std::memset(m_buffer + m_position, 0, end - m_position);
+        m_position = end;
+    }
+    if (m_position >= m_signal_position) {
+        signal_threshold();
+    }
+    return true;
+}
+
+bool Logger::write_gap_record() noexcept {
+    uint8_t payload[2 * kMaxVarintSize];
+    const uint8_t* end = encode_varint(encode_varint(payload, m_dropped_records), m_dropped_bytes);
+    if (!write_record(RecordType::Gap, Level::Warn, 0, payload, static_cast<std::size_t>(end - payload))) {
+        return false; // stays pending until a buffer with room comes along
+    }
+    m_dropped_records = 0;
+    m_dropped_bytes = 0;
+    return true;
+}
+
+bool Logger::log(std::u16string_view str) noexcept {
+    return log_unicode(str.data(), str.size());
+}
+
+bool Logger::log(std::u32string_view str) noexcept {
+    return log_unicode(str.data(), str.size());
+}
+
 } // namespace log_buffer
@@ -0,0 +1,92 @@
+#include "log_buffer/site_sketch.hpp"
+#include "log_buffer/decoder.hpp"
+#include "log_buffer/logger.hpp"
+#include "detail.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace log_buffer {
+
+SiteSketch::SiteSketch(std::size_t width, std::size_t depth, std::size_t top)
+    : m_mask(detail::round_up_pow2(width < 2 ? std::size_t{2} : width) - 1), m_depth(depth < 1 ? 1 : depth),
+      m_counters(new uint64_t[(m_mask + 1) * m_depth]()), m_top_capacity(top < 1 ? 1 : top), m_top_size(0),
+      m_top(new SiteCount[m_top_capacity]), m_sorted(new SiteCount[m_top_capacity]),
+      m_scratch(new uint8_t[max_payload_size()]), m_total(0) {}
+
+void SiteSketch::add(uint32_t key, uint64_t weight) noexcept {
+    uint64_t estimate = UINT64_MAX;
+    detail::for_each_probe(detail::mix(key), m_depth, m_mask, [&](uint64_t row, uint64_t slot) {
+        uint64_t& counter = m_counters[row * (m_mask + 1) + slot];
+        counter += weight;
+        estimate = std::min(estimate, counter);
+        return true;
+    });
+    m_total += weight;
+
+    // K is small, so a linear scan beats maintaining a heap plus a key index
+    std::size_t lightest = 0;
+    for (std::size_t i = 0; i < m_top_size; ++i) {
+        if (m_top[i].key == key) {
+            m_top[i].count = estimate;
+            return;
+        }
+        if (m_top[i].count < m_top[lightest].count) {
+            lightest = i;
+        }
+    }
+    if (m_top_size < m_top_capacity) {
+        m_top[m_top_size++] = SiteCount{key, estimate};
+    } else if (estimate > m_top[lightest].count) {
+        m_top[lightest] = SiteCount{key, estimate};
+    }
+}
+
+void SiteSketch::add_buffer(const uint8_t* data, std::size_t size) noexcept {
+    RecordReader reader(data, size);
+    RecordView record;
+    while (reader.next(record)) {
+        if (record.type == RecordType::Log) {
+            add(record.has_metadata ? record.site : record.tag, record.size);
+        }
+    }
+}
+
+uint64_t SiteSketch::estimate(uint32_t key) const noexcept {
+    uint64_t estimate = UINT64_MAX;
+    detail::for_each_probe(detail::mix(key), m_depth, m_mask, [&](uint64_t row, uint64_t slot) {
+        estimate = std::min(estimate, m_counters[row * (m_mask + 1) + slot]);
+        return true;
+    });
+    return estimate;
+}
+
+std::size_t SiteSketch::top(SiteCount* out, std::size_t max) const noexcept {
+    const std::size_t n = std::min(max, m_top_size);
+    std::partial_sort_copy(m_top.get(), m_top.get() + m_top_size, out, out + n,
+                           [](const SiteCount& a, const SiteCount& b) {
+                               return a.count > b.count || (a.count == b.count && a.key < b.key);
+                           });
+    return n;
+}
+
+bool SiteSketch::emit(Logger& logger, Level level, uint16_t tag) noexcept {
+    if (logger.m_record_start != Logger::kNoRecord) {
+        return false;
+    }
+    const std::size_t n = top(m_sorted.get(), m_top_capacity);
+    uint8_t* out = encode_varint(encode_varint(m_scratch.get(), m_total), n);
+    for (std::size_t i = 0; i < n; ++i) {
+        out = encode_varint(encode_varint(out, m_sorted[i].key), m_sorted[i].count);
+    }
+    return logger.write_record(RecordType::SiteStats, level, tag, m_scratch.get(),
+                               static_cast<std::size_t>(out - m_scratch.get()));
+}
+
+void SiteSketch::clear() noexcept {
+    std::fill(m_counters.get(), m_counters.get() + (m_mask + 1) * m_depth, 0);
+    m_top_size = 0;
+    m_total = 0;
+}
+
+} // namespace log_buffer
@@ -0,0 +1,166 @@
+#include "log_buffer/time_index.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define LOG_BUFFER_HAVE_POSIX_IO 1
+#endif
+
+namespace log_buffer {
+
+namespace {
+
+#ifdef LOG_BUFFER_HAVE_POSIX_IO
+bool write_all(int fd, const void* data, std::size_t size) noexcept {
+    const char* p = static_cast<const char*>(data);
+    while (size != 0) {
+        const ssize_t n = ::write(fd, p, size);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+#endif
+
+} // namespace
+
+bool block_time_range(const uint8_t* data, std::size_t size, uint64_t& first_ns, uint64_t& last_ns) noexcept {
+    first_ns = UINT64_MAX;
+    last_ns = 0;
+    RecordReader reader(data, size);
+    RecordView record;
+    while (reader.next(record)) {
+        uint64_t time_ns = 0;
+        if (record_time_ns(record, reader.buffer_header(), time_ns)) {
+            first_ns = std::min(first_ns, time_ns);
+            last_ns = std::max(last_ns, time_ns);
+        }
+    }
+    return first_ns <= last_ns;
+}
+
+bool TimeIndexWriter::open(const char* path, uint64_t offset) noexcept {
+    close();
+#ifdef LOG_BUFFER_HAVE_POSIX_IO
+    m_fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        return false;
+    }
+    m_offset = offset;
+    const TimeIndexHeader header{kTimeIndexMagic, kTimeIndexVersion, sizeof(TimeIndexEntry), 0};
+    if (!write_all(m_fd, &header, sizeof(header))) {
+        close();
+        return false;
+    }
+    return true;
+#else
+    (void)path;
+    (void)offset;
+    return false;
+#endif
+}
+
+void TimeIndexWriter::close() noexcept {
+#ifdef LOG_BUFFER_HAVE_POSIX_IO
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+#endif
+}
+
+bool TimeIndexWriter::add(const uint8_t* data, std::size_t size) noexcept {
+    TimeIndexEntry entry{0, 0, m_offset, size};
+    m_offset += size;
+    if (!block_time_range(data, size, entry.first_ns, entry.last_ns)) {
+        return true;
+    }
+#ifdef LOG_BUFFER_HAVE_POSIX_IO
+    return m_fd >= 0 && write_all(m_fd, &entry, sizeof(entry));
+#else
+    return false;
+#endif
+}
+
+bool TimeIndex::load(const char* path) {
+    MappedDump file;
+    TimeIndexHeader header;
+    if (!file.open(path) || file.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != kTimeIndexMagic || header.version > kTimeIndexVersion
+        || header.entry_size < sizeof(TimeIndexEntry)) {
+        return false;
+    }
+    // Newer writers may grow entries; read the fields we know. A torn last entry is dropped.
+    std::vector<TimeIndexEntry> entries((file.size() - sizeof(header)) / header.entry_size);
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        std::memcpy(&entries[i], file.data() + sizeof(header) + i * header.entry_size, sizeof(TimeIndexEntry));
+    }
+    assign(std::move(entries));
+    return true;
+}
+
+void TimeIndex::assign(std::vector<TimeIndexEntry> entries) {
+    m_entries = std::move(entries);
+    std::stable_sort(m_entries.begin(), m_entries.end(),
+                     [](const TimeIndexEntry& a, const TimeIndexEntry& b) { return a.first_ns < b.first_ns; });
+    m_max_last.resize(m_entries.size());
+    uint64_t max_last = 0;
+    for (std::size_t i = 0; i < m_entries.size(); ++i) {
+        max_last = std::max(max_last, m_entries[i].last_ns);
+        m_max_last[i] = max_last;
+    }
+}
+
+void TimeIndex::candidates(uint64_t from_ns, uint64_t to_ns, std::size_t& begin, std::size_t& end) const noexcept {
+    // Entries before begin all end before from_ns; entries from end on all start after to_ns
+    begin = static_cast<std::size_t>(std::lower_bound(m_max_last.begin(), m_max_last.end(), from_ns)
+                                     - m_max_last.begin());
+    end = static_cast<std::size_t>(
+        std::upper_bound(m_entries.begin(), m_entries.end(), to_ns,
+                         [](uint64_t time, const TimeIndexEntry& entry) { return time < entry.first_ns; })
+        - m_entries.begin());
+    if (end < begin) {
+        end = begin;
+    }
+}
+
+TimeRangeStats TimeIndex::extract(const uint8_t* data, std::size_t size, uint64_t from_ns, uint64_t to_ns,
+                                  const Callback& on_record) const {
+    TimeRangeStats stats;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    candidates(from_ns, to_ns, begin, end);
+    for (std::size_t i = begin; i < end; ++i) {
+        const TimeIndexEntry& entry = m_entries[i];
+        if (entry.last_ns < from_ns || entry.offset > size || entry.size > size - entry.offset) {
+            continue;
+        }
+        ++stats.blocks;
+        stats.bytes += entry.size;
+        RecordReader reader(data + entry.offset, static_cast<std::size_t>(entry.size));
+        RecordView record;
+        while (reader.next(record)) {
+            uint64_t time_ns = 0;
+            if (!record_time_ns(record, reader.buffer_header(), time_ns)) {
+                continue;
+            }
+            ++stats.records;
+            if (time_ns >= from_ns && time_ns <= to_ns) {
+                ++stats.matches;
+                on_record(record, time_ns);
+            }
+        }
+    }
+    return stats;
+}
+
+} // namespace log_buffer
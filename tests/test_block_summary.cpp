@@ -0,0 +1,177 @@
+#include "log_buffer/block_summary.hpp"
+#include "log_buffer/decoder.hpp"
+#include "log_buffer/drain.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace log_buffer;
+
+namespace {
+
+/// Fill a buffer with records "request req-<first..first+count) user <n>".
+std::vector<uint8_t> make_block(int first, int count) {
+    std::vector<uint8_t> buffer(64 * 1024);
+    Logger logger(buffer.data(), buffer.size());
+    logger.set_buffer_header(true);
+    for (int i = first; i < first + count; ++i) {
+        logger.begin_record(Level::Info, 1);
+        logger << "request" << ("req-" + std::to_string(i)).c_str() << "user" << i % 7;
+        logger.end_record();
+    }
+    buffer.resize(logger.bytes_written());
+    return buffer;
+}
+
+/// Summarize each block and concatenate summary + block, as a Drainer sink would.
+std::vector<uint8_t> make_dump(BlockSummarizer& summarizer, const std::vector<std::vector<uint8_t>>& blocks) {
+    std::vector<uint8_t> dump;
+    for (const auto& block : blocks) {
+        summarizer.summarize(block.data(), block.size());
+        dump.insert(dump.end(), summarizer.data(), summarizer.data() + summarizer.size());
+        dump.insert(dump.end(), block.begin(), block.end());
+    }
+    return dump;
+}
+
+} // namespace
+
+TEST(BlockSummaryTest, Tokens) {
+    std::vector<std::string_view> tokens;
+    for_each_token("GET /api/v1?id=req-42, user_7.", [&](std::string_view t) { tokens.push_back(t); });
+    ASSERT_EQ(tokens.size(), 6u);
+    EXPECT_EQ(tokens[0], "GET");
+    EXPECT_EQ(tokens[3], "id");
+    EXPECT_EQ(tokens[4], "req-42");
+    EXPECT_EQ(tokens[5], "user_7");
+    tokens.clear();
+    for_each_token(" ,. ", [&](std::string_view t) { tokens.push_back(t); });
+    EXPECT_TRUE(tokens.empty());
+}
+
+TEST(BlockSummaryTest, FilterHasNoFalseNegatives) {
+    const std::vector<uint8_t> block = make_block(0, 500);
+    BlockSummarizer summarizer;
+    summarizer.summarize(block.data(), block.size());
+    EXPECT_EQ(summarizer.size() % kRecordAlignment, 0u);
+
+    RecordReader reader(summarizer.data(), summarizer.size());
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    BlockSummaryHeader header;
+    const uint8_t* filter = nullptr;
+    ASSERT_TRUE(decode_block_summary(record, header, filter));
+    EXPECT_EQ(header.block_size, block.size());
+    EXPECT_EQ(header.tokens, 500u + 2u + 7u);  // IDs, "request" and "user", digits 0-6
+    EXPECT_GE(header.filter_bits, header.tokens * 10);
+
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_TRUE(block_may_contain(header, filter, hash_token("req-" + std::to_string(i))));
+    }
+    EXPECT_TRUE(block_may_contain(header, filter, hash_token("user")));
+
+    // About 1% of absent tokens pass at 10+ bits per token
+    int false_positives = 0;
+    for (int i = 1000; i < 11000; ++i) {
+        false_positives += block_may_contain(header, filter, hash_token("req-" + std::to_string(i)));
+    }
+    EXPECT_LT(false_positives, 300);
+}
+
+TEST(BlockSummaryTest, EmptyBlock) {
+    uint8_t buffer[128];
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_buffer_header(true);
+    BlockSummarizer summarizer;
+    summarizer.summarize(logger.data(), logger.bytes_written());
+
+    RecordReader reader(summarizer.data(), summarizer.size());
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    BlockSummaryHeader header;
+    const uint8_t* filter = nullptr;
+    ASSERT_TRUE(decode_block_summary(record, header, filter));
+    EXPECT_EQ(header.filter_bits, 0u);
+    EXPECT_FALSE(block_may_contain(header, filter, hash_token("anything")));
+}
+
+TEST(BlockSummaryTest, SearchSkipsBlocks) {
+    std::vector<std::vector<uint8_t>> blocks;
+    for (int b = 0; b < 20; ++b) {
+        blocks.push_back(make_block(b * 100, 100));
+    }
+    BlockSummarizer summarizer;
+    const std::vector<uint8_t> dump = make_dump(summarizer, blocks);
+
+    std::vector<std::string> found;
+    BlockSearchStats stats = search_blocks(dump.data(), dump.size(), "req-1234", StringFormat::NulTerminated,
+                                           [&](const RecordView& record) {
+                                               std::string text;
+                                               format_text(record.data, record.size, text);
+                                               found.push_back(text);
+                                           });
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0], "info 1: request req-1234 user 2\n");
+    EXPECT_EQ(stats.blocks, 20u);
+    EXPECT_GE(stats.skipped, 17u);
+    EXPECT_EQ(stats.records, (20 - stats.skipped) * 100);
+
+    // Every token must match whole: "req" alone is not a token of any record
+    stats = search_blocks(dump.data(), dump.size(), "req", StringFormat::NulTerminated, [](const RecordView&) {});
+    EXPECT_EQ(stats.matches, 0u);
+
+    // Several tokens: records holding all of them
+    std::size_t count = 0;
+    stats = search_blocks(dump.data(), dump.size(), "user 3 request", StringFormat::NulTerminated,
+                          [&](const RecordView&) { ++count; });
+    EXPECT_EQ(stats.skipped, 0u);
+    EXPECT_EQ(count, 2000u / 7 + (2000 % 7 > 3));
+
+    // Queries without tokens match nothing
+    stats = search_blocks(dump.data(), dump.size(), " -- ", StringFormat::NulTerminated, [](const RecordView&) {});
+    EXPECT_EQ(stats.records, 0u);
+}
+
+TEST(BlockSummaryTest, DrainerWritesSummaryBeforeBlock) {
+    BufferPool pool(2, 1024);
+    std::vector<uint8_t> dump;
+    std::vector<std::size_t> chunks;
+    Drainer drainer(pool, [&](const uint8_t* data, std::size_t size) {
+        dump.insert(dump.end(), data, data + size);
+        chunks.push_back(size);
+    });
+    BlockSummarizer summarizer;
+    drainer.set_block_summarizer(&summarizer);
+
+    Logger logger(nullptr, 0);
+    for (const char* id : {"alpha", "beta"}) {
+        ASSERT_TRUE(pool.acquire(logger));
+        logger.begin_record(Level::Warn, 2);
+        logger << "id" << id;
+        logger.end_record();
+        pool.seal(logger);
+    }
+    EXPECT_EQ(drainer.drain(), 2u);
+    ASSERT_EQ(chunks.size(), 4u);  // summary, buffer, summary, buffer
+
+    RecordReader reader(dump.data(), dump.size());
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, RecordType::BlockSummary);
+    std::string text;
+    format_text(dump.data(), dump.size(), text);
+    EXPECT_NE(text.find("block summary"), std::string::npos);
+
+    std::vector<std::string> found;
+    const BlockSearchStats stats = search_blocks(dump.data(), dump.size(), "beta", StringFormat::NulTerminated,
+                                                 [&](const RecordView& record) {
+                                                     std::string line;
+                                                     format_text(record.data, record.size, line);
+                                                     found.push_back(line);
+                                                 });
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0], "warn 2: id beta\n");
+    EXPECT_EQ(stats.blocks, 2u);
+    EXPECT_EQ(stats.skipped, 1u);
+    EXPECT_EQ(stats.bytes_skipped, chunks[1]);
+}
@@ -0,0 +1,525 @@
+#include "log_buffer/decoder.hpp"
+#include "log_buffer/logger.hpp"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+using namespace log_buffer;
+
+class DecoderTest : public ::testing::Test {
+protected:
+    static constexpr size_t kBufferSize = 256;
+    alignas(kRecordAlignment) uint8_t buffer[kBufferSize];
+    
+    void SetUp() override {
+        std::memset(buffer, 0xAA, sizeof(buffer));
+    }
+    
+    static void write_record(Logger& logger, Level level, uint16_t tag, const char* text) {
+        ASSERT_TRUE(logger.begin_record(level, tag));
+        ASSERT_TRUE(logger.log(text));
+        ASSERT_TRUE(logger.end_record());
+    }
+    
+    static std::string payload_text(const RecordView& record) {
+        return std::string(reinterpret_cast<const char*>(record.payload()));
+    }
+};
+
+TEST_F(DecoderTest, ReadsRecordsInOrder) {
+    Logger logger(buffer, sizeof(buffer));
+    write_record(logger, Level::Info, 1, "first");
+    write_record(logger, Level::Error, 2, "second record");
+    
+    RecordReader reader(logger);
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.level, Level::Info);
+    EXPECT_EQ(record.tag, 1);
+    EXPECT_EQ(payload_text(record), "first");
+    EXPECT_EQ(record.payload_size(), sizeof("first"));
+    
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.level, Level::Error);
+    EXPECT_EQ(record.tag, 2);
+    EXPECT_EQ(payload_text(record), "second record");
+    
+    EXPECT_FALSE(reader.next(record));
+    EXPECT_FALSE(reader.malformed());
+    EXPECT_EQ(reader.offset(), logger.bytes_written());
+}
+
+TEST_F(DecoderTest, SkipsPadding) {
+    // Zero-filled slots before a record are skipped as padding
+    std::memset(buffer, 0, 3 * kRecordAlignment);
+    Logger framed(buffer + 3 * kRecordAlignment, sizeof(buffer) - 3 * kRecordAlignment);
+    write_record(framed, Level::Debug, 0, "after gap");
+    
+    RecordReader reader(buffer, 3 * kRecordAlignment + framed.bytes_written());
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(payload_text(record), "after gap");
+    EXPECT_FALSE(reader.next(record));
+}
+
+TEST_F(DecoderTest, DetectsMalformedHeader) {
+    const RecordHeader bad{1000, static_cast<uint8_t>(RecordType::Log), 0, 0};
+    std::memcpy(buffer, &bad, sizeof(bad));
+    
+    RecordReader reader(buffer, 64);
+    RecordView record;
+    EXPECT_FALSE(reader.next(record));
+    EXPECT_TRUE(reader.malformed());
+}
+
+TEST_F(DecoderTest, GatherCoalescesAdjacentMatches) {
+    Logger logger(buffer, sizeof(buffer));
+    write_record(logger, Level::Error, 1, "e1");
+    write_record(logger, Level::Error, 1, "e2");
+    write_record(logger, Level::Debug, 1, "d1");
+    write_record(logger, Level::Warn, 2, "w1");
+    
+    RecordFilter filter;
+    filter.min_level = Level::Warn;
+    
+    iovec iov[4];
+    std::size_t offset = 0;
+    ASSERT_EQ(gather_records(logger, filter, iov, 4, offset), 2u);
+    EXPECT_EQ(offset, logger.bytes_written());
+    EXPECT_EQ(iov[0].iov_base, buffer);
+    EXPECT_EQ(iov[0].iov_len % kRecordAlignment, 0u);
+    
+    // The gathered bytes form a valid record stream of just the matches
+    std::string joined;
+    for (std::size_t i = 0; i < 2; ++i) {
+        joined.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    RecordReader reader(reinterpret_cast<const uint8_t*>(joined.data()), joined.size());
+    RecordView record;
+    std::string seen;
+    while (reader.next(record)) {
+        seen += payload_text(record) + ",";
+    }
+    EXPECT_EQ(seen, "e1,e2,w1,");
+}
+
+TEST_F(DecoderTest, GatherByTag) {
+    Logger logger(buffer, sizeof(buffer));
+    write_record(logger, Level::Info, 1, "a");
+    write_record(logger, Level::Info, 2, "b");
+    write_record(logger, Level::Info, 1, "c");
+    
+    RecordFilter filter;
+    filter.tag = 2;
+    
+    iovec iov[4];
+    std::size_t offset = 0;
+    ASSERT_EQ(gather_records(logger, filter, iov, 4, offset), 1u);
+    RecordReader reader(static_cast<const uint8_t*>(iov[0].iov_base), iov[0].iov_len);
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(payload_text(record), "b");
+}
+
+TEST_F(DecoderTest, GatherResumesWhenOutputFull) {
+    Logger logger(buffer, sizeof(buffer));
+    write_record(logger, Level::Info, 1, "a");
+    write_record(logger, Level::Info, 2, "b");
+    write_record(logger, Level::Info, 1, "c");
+    write_record(logger, Level::Info, 2, "d");
+    write_record(logger, Level::Info, 1, "e");
+    
+    RecordFilter filter;
+    filter.tag = 1;
+    
+    iovec iov[1];
+    std::size_t offset = 0;
+    std::string seen;
+    while (offset < logger.bytes_written()) {
+        ASSERT_EQ(gather_records(logger, filter, iov, 1, offset), 1u);
+        RecordReader reader(static_cast<const uint8_t*>(iov[0].iov_base), iov[0].iov_len);
+        RecordView record;
+        while (reader.next(record)) {
+            seen += payload_text(record);
+        }
+    }
+    EXPECT_EQ(seen, "ace");
+}
+
+TEST_F(DecoderTest, ChildRecordsReadThroughParent) {
+    Logger parent(buffer, sizeof(buffer));
+    Logger stage1 = parent.child(64);
+    Logger stage2 = parent.child(64);
+    
+    // Fill the stages out of order; the parent still reads in region order
+    write_record(stage2, Level::Info, 2, "stage two");
+    write_record(stage1, Level::Info, 1, "stage one");
+    write_record(stage1, Level::Info, 1, "more one");
+    stage1.close();
+    stage2.close();
+    
+    RecordReader reader(parent);
+    RecordView record;
+    std::string seen;
+    while (reader.next(record)) {
+        seen += payload_text(record) + ",";
+    }
+    EXPECT_FALSE(reader.malformed());
+    EXPECT_EQ(seen, "stage one,more one,stage two,");
+}
+
+TEST_F(DecoderTest, AppendMergesRecordStreams) {
+    alignas(kRecordAlignment) uint8_t stage_buffer[64];
+    Logger merged(buffer, sizeof(buffer));
+    Logger stage(stage_buffer, sizeof(stage_buffer));
+    write_record(merged, Level::Info, 1, "request");
+    write_record(stage, Level::Debug, 2, "stage a");
+    write_record(stage, Level::Warn, 2, "stage b");
+    
+    ASSERT_TRUE(merged.append(stage));
+    
+    RecordReader reader(merged);
+    RecordView record;
+    std::string seen;
+    while (reader.next(record)) {
+        seen += payload_text(record) + ",";
+    }
+    EXPECT_FALSE(reader.malformed());
+    EXPECT_EQ(seen, "request,stage a,stage b,");
+}
+
+TEST_F(DecoderTest, AppendRebasesTimestamps) {
+    alignas(kRecordAlignment) uint8_t early_buffer[128];
+    alignas(kRecordAlignment) uint8_t late_buffer[128];
+    Logger early(early_buffer, sizeof(early_buffer));
+    early.set_buffer_header(true).set_record_metadata(true);
+    write_record(early, Level::Info, 1, "early");
+    ::usleep(20000);
+    Logger merged(buffer, sizeof(buffer));
+    merged.set_buffer_header(true).set_record_metadata(true);
+    ::usleep(20000);
+    Logger late(late_buffer, sizeof(late_buffer));
+    late.set_buffer_header(true).set_record_metadata(true);
+    write_record(late, Level::Info, 1, "late");
+    
+    BufferHeader merged_header;
+    BufferHeader late_header;
+    ASSERT_TRUE(read_buffer_header(merged.data(), merged.bytes_written(), merged_header));
+    ASSERT_TRUE(read_buffer_header(late.data(), late.bytes_written(), late_header));
+    RecordReader late_reader(late);
+    RecordView record;
+    ASSERT_TRUE(late_reader.next(record));
+    const uint64_t late_ns = late_header.steady_ns + uint64_t{record.timestamp_us} * 1000;
+    
+    ASSERT_TRUE(merged.append(late));
+    ASSERT_TRUE(merged.append(early));
+    
+    RecordReader reader(merged);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(payload_text(record), "late");
+    // Same steady_clock time, now relative to the merged buffer's epoch
+    EXPECT_EQ(record.timestamp_us, (late_ns - merged_header.steady_ns) / 1000);
+    EXPECT_GE(record.timestamp_us, 20000u);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(payload_text(record), "early");
+    EXPECT_EQ(record.timestamp_us, 0u); // written before the epoch: saturates at 0
+    EXPECT_FALSE(reader.next(record));
+    EXPECT_FALSE(reader.malformed());
+}
+
+TEST_F(DecoderTest, GapRecords) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_gap_records(true);
+    write_record(logger, Level::Info, 1, "kept");
+    
+    // Fill up and lose two records
+    const std::string big(kBufferSize, 'x');
+    for (int i = 0; i < 2; ++i) {
+        logger.begin_record(Level::Info, 1);
+        logger.log(big);
+        EXPECT_FALSE(logger.end_record());
+    }
+    logger.reset();
+    write_record(logger, Level::Info, 1, "after");
+    
+    RecordReader reader(logger);
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    ASSERT_TRUE(decode_gap(record, records, bytes));
+    EXPECT_EQ(records, 2u);
+    EXPECT_EQ(bytes, 2 * (sizeof(RecordHeader) + kBufferSize + 1));
+    
+    // Gap records are not log records
+    EXPECT_FALSE(RecordFilter{}.matches(record));
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_FALSE(decode_gap(record, records, bytes));
+    EXPECT_EQ(payload_text(record), "after");
+}
+
+TEST_F(DecoderTest, SequenceNumbersAndGaps) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_sequence_numbers(true).set_next_sequence(500);
+    write_record(logger, Level::Info, 1, "a");  // 500
+    write_record(logger, Level::Info, 1, "b");  // 501
+    
+    // Two records dropped: 502, 503
+    const std::string big(kBufferSize, 'x');
+    for (int i = 0; i < 2; ++i) {
+        logger.begin_record(Level::Info, 1);
+        logger.log(big);
+        logger.end_record();
+    }
+    write_record(logger, Level::Info, 1, "c");  // 504
+    
+    RecordReader reader(logger);
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_TRUE(record.has_sequence);
+    EXPECT_EQ(record.sequence, 500u);
+    EXPECT_EQ(payload_text(record), "a");
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.sequence, 501u);
+    EXPECT_EQ(record.sequence_gap, 0u);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.sequence, 504u);
+    EXPECT_EQ(record.sequence_gap, 2u);
+    EXPECT_EQ(payload_text(record), "c");
+    EXPECT_EQ(reader.missing_records(), 2u);
+}
+
+TEST_F(DecoderTest, SequenceTrackerAcrossBuffers) {
+    alignas(kRecordAlignment) uint8_t second[64];
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_sequence_numbers(true);
+    write_record(logger, Level::Info, 1, "a");
+    write_record(logger, Level::Info, 1, "b");
+    
+    // Rotate; one record is lost in between (never written anywhere)
+    const DetachedBuffer full = logger.detach();
+    logger.attach(second, sizeof(second));
+    logger.set_next_sequence(logger.next_sequence() + 1);
+    write_record(logger, Level::Info, 1, "d");
+    
+    SequenceTracker tracker;
+    uint64_t skipped = 0;
+    for (const auto& part : {std::make_pair(full.data, full.size),
+                             std::make_pair(static_cast<uint8_t*>(second), logger.bytes_written())}) {
+        RecordReader reader(part.first, part.second);
+        RecordView record;
+        while (reader.next(record)) {
+            ASSERT_TRUE(record.has_sequence);
+            skipped += tracker.observe(record.sequence);
+        }
+    }
+    EXPECT_EQ(skipped, 1u);
+    EXPECT_EQ(tracker.received(), 3u);
+    EXPECT_EQ(tracker.missing(), 1u);
+    EXPECT_EQ(tracker.reordered(), 0u);
+}
+
+TEST_F(DecoderTest, SequenceSurvivesAppendAndChild) {
+    alignas(kRecordAlignment) uint8_t other_buffer[64];
+    Logger logger(buffer, sizeof(buffer));
+    Logger other(other_buffer, sizeof(other_buffer));
+    logger.set_sequence_numbers(true);
+    other.set_sequence_numbers(true).set_next_sequence(9000);
+    
+    write_record(logger, Level::Info, 1, "own0");
+    write_record(other, Level::Info, 2, "other");
+    logger.append(other);
+    Logger section = logger.child(32);
+    write_record(section, Level::Info, 3, "child");
+    section.close();
+    write_record(logger, Level::Info, 1, "own1");
+    
+    RecordReader reader(logger);
+    RecordView record;
+    std::string seen;
+    while (reader.next(record)) {
+        ASSERT_TRUE(record.has_sequence);
+        seen += payload_text(record) + "=" + std::to_string(record.sequence) + ",";
+    }
+    EXPECT_EQ(seen, "own0=0,other=9000,child=0,own1=1,");
+    EXPECT_EQ(reader.missing_records(), 0u);
+}
+
+TEST_F(DecoderTest, BufferHeader) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_format_hash(7).set_buffer_header(true);
+    write_record(logger, Level::Info, 1, "first");
+    write_record(logger, Level::Warn, 2, "second");
+    
+    BufferHeader header;
+    ASSERT_TRUE(read_buffer_header(logger.data(), logger.bytes_written(), header));
+    EXPECT_EQ(header.format_hash, 7u);
+    EXPECT_EQ(header.header_size, sizeof(BufferHeader));
+    
+    RecordReader reader(logger);
+    ASSERT_NE(reader.buffer_header(), nullptr);
+    EXPECT_EQ(reader.buffer_header()->pid, header.pid);
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(payload_text(record), "first");
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(payload_text(record), "second");
+    EXPECT_FALSE(reader.next(record));
+    EXPECT_FALSE(reader.malformed());
+    
+    // Gathering from offset 0 skips the header too
+    struct iovec iov[2];
+    std::size_t offset = 0;
+    ASSERT_EQ(gather_records(logger, RecordFilter{}, iov, 2, offset), 1u);
+    EXPECT_EQ(iov[0].iov_base, logger.data() + sizeof(BufferHeader));
+}
+
+TEST_F(DecoderTest, NoBufferHeader) {
+    Logger logger(buffer, sizeof(buffer));
+    write_record(logger, Level::Info, 1, "plain");
+    BufferHeader header;
+    EXPECT_FALSE(read_buffer_header(logger.data(), logger.bytes_written(), header));
+    RecordReader reader(logger);
+    EXPECT_EQ(reader.buffer_header(), nullptr);
+}
+
+TEST_F(DecoderTest, RecordMetadata) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_buffer_header(true).set_record_metadata(true);
+    ASSERT_TRUE(logger.begin_record(Level::Info, 1, 77));
+    ASSERT_TRUE(logger.log("hello"));
+    ASSERT_TRUE(logger.end_record());
+    write_record(logger, Level::Info, 1, "plain site");
+    
+    RecordReader reader(logger);
+    ASSERT_NE(reader.buffer_header(), nullptr);
+    EXPECT_EQ(reader.buffer_header()->version, kBufferFormatVersion);
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_TRUE(record.has_metadata);
+    EXPECT_EQ(record.site, 77u);
+    EXPECT_EQ(payload_text(record), "hello");
+    const uint32_t first_time = record.timestamp_us;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.site, 0u);
+    EXPECT_GE(record.timestamp_us, first_time);
+}
+
+TEST_F(DecoderTest, FieldReader) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.begin_record(Level::Info);
+    logger << "name" << 42 << -7 << std::hex << 255 << std::uppercase << 3054 << std::oct << 8;
+    logger.end_record();
+    
+    RecordReader reader(logger);
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    FieldReader fields(record);
+    std::string_view name;
+    int value = 0;
+    ASSERT_TRUE(fields.read_string(name));
+    EXPECT_EQ(name, "name");
+    EXPECT_EQ(name.data(), reinterpret_cast<const char*>(record.payload()));  // no copy
+    ASSERT_TRUE(fields.read_int(value));
+    EXPECT_EQ(value, 42);
+    ASSERT_TRUE(fields.read_int(value));
+    EXPECT_EQ(value, -7);
+    ASSERT_TRUE(fields.read_int(value));
+    EXPECT_EQ(value, 255);
+    ASSERT_TRUE(fields.read_int(value));
+    EXPECT_EQ(value, 3054);
+    ASSERT_TRUE(fields.read_int(value));
+    EXPECT_EQ(value, 8);
+    EXPECT_EQ(fields.remaining(), 0u);
+    EXPECT_FALSE(fields.read_string(name));
+}
+
+TEST_F(DecoderTest, FieldReaderLengthPrefixed) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_string_format(StringFormat::LengthPrefixed);
+    logger.begin_record(Level::Info);
+    logger << std::string_view("a\0b", 3) << 1000u;
+    logger.end_record();
+    
+    RecordReader reader(logger);
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    FieldReader fields(record, StringFormat::LengthPrefixed);
+    std::string_view text;
+    uint8_t small = 0;
+    uint32_t value = 0;
+    ASSERT_TRUE(fields.read_string(text));
+    EXPECT_EQ(text, std::string_view("a\0b", 3));
+    EXPECT_FALSE(fields.read_int(small));  // 1000 does not fit; nothing consumed
+    ASSERT_TRUE(fields.read_int(value));
+    EXPECT_EQ(value, 1000u);
+}
+
+TEST_F(DecoderTest, ConcatenatedBuffers) {
+    alignas(kRecordAlignment) uint8_t dump[2 * kBufferSize];
+    Logger logger(dump, kBufferSize);
+    logger.set_buffer_header(true).set_sequence_numbers(true);
+    write_record(logger, Level::Info, 1, "one");
+    const std::size_t first_size = logger.bytes_written();
+    
+    // Second buffer of the same producer, appended right after the first
+    logger.attach(dump + first_size, sizeof(dump) - first_size);
+    write_record(logger, Level::Info, 1, "two");
+    
+    RecordReader reader(dump, first_size + logger.bytes_written());
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(payload_text(record), "one");
+    EXPECT_EQ(reader.buffer_header()->epoch, 0u);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(payload_text(record), "two");
+    EXPECT_EQ(record.sequence, 1u);
+    EXPECT_EQ(reader.buffer_header()->epoch, 1u);
+    EXPECT_FALSE(reader.next(record));
+    EXPECT_FALSE(reader.malformed());
+}
+
+TEST_F(DecoderTest, FormatText) {
+    Logger logger(buffer, kBufferSize);
+    logger.set_gap_records(true).set_sequence_numbers(true);
+    logger.begin_record(Level::Info, 1);
+    logger.log(std::string(300, 'x'));  // dropped
+    logger.end_record();
+    logger.reset();                       // starts with a gap record
+    logger.begin_record(Level::Warn, 7);
+    logger << "disk" << 93 << "line\nbreak";
+    logger.end_record();
+
+    std::string text = "> ";
+    format_text(logger.data(), logger.bytes_written(), text);
+    EXPECT_EQ(text, "> warn 0: dropped 1 records, 310 bytes\n"
+                    "warn 7 #1: disk 93 line\\x0abreak\n");
+}
+
+TEST_F(DecoderTest, MappedDump) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_buffer_header(true);
+    write_record(logger, Level::Error, 4, "on disk");
+    
+    char path[] = "/tmp/log_buffer_dumpXXXXXX";
+    const int fd = ::mkstemp(path);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::write(fd, logger.data(), logger.bytes_written()), static_cast<ssize_t>(logger.bytes_written()));
+    ::close(fd);
+    
+    MappedDump dump;
+    ASSERT_TRUE(dump.open(path));
+    ::unlink(path);
+    ASSERT_EQ(dump.size(), logger.bytes_written());
+    RecordReader reader(dump.data(), dump.size());
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.level, Level::Error);
+    EXPECT_EQ(record.payload_view(), std::string_view("on disk", 8));
+    
+    MappedDump moved(std::move(dump));
+    EXPECT_EQ(dump.data(), nullptr);
+    EXPECT_NE(moved.data(), nullptr);
+    EXPECT_FALSE(dump.open("/nonexistent/log_buffer_dump"));
+}
@@ -0,0 +1,227 @@
+#include "log_buffer/drain.hpp"
+#include "log_buffer/decoder.hpp"
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace log_buffer;
+using namespace std::chrono_literals;
+
+TEST(NotifierTest, PendingSignalConsumedOnce) {
+    Notifier notifier;
+    notifier.notify();
+    notifier.notify();  // coalesced with the first
+    EXPECT_TRUE(notifier.wait(1ms));
+    EXPECT_FALSE(notifier.wait(1ms));
+}
+
+TEST(NotifierTest, WakesParkedConsumer) {
+    Notifier notifier;
+    std::thread producer([&] {
+        std::this_thread::sleep_for(20ms);
+        notifier.notify();
+    });
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(notifier.wait(10s));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+    producer.join();
+}
+
+TEST(NotifierTest, SpinBudgetAdapts) {
+    Notifier notifier;
+    const uint32_t initial = notifier.spin_limit();
+    notifier.notify();
+    EXPECT_TRUE(notifier.wait(1ms));  // served while spinning
+    EXPECT_GT(notifier.spin_limit(), initial);
+    EXPECT_FALSE(notifier.wait(1ms)); // had to park
+    EXPECT_EQ(notifier.spin_limit(), initial);
+}
+
+TEST(BufferQueueTest, FifoAndBounded) {
+    BufferQueue queue(3);
+    EXPECT_EQ(queue.capacity(), 4u);
+    uint8_t storage[4];
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.push(DetachedBuffer{storage + i, 0, 1}));
+    }
+    EXPECT_FALSE(queue.push(DetachedBuffer{storage, 0, 1}));
+
+    DetachedBuffer buffer;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.pop(buffer));
+        EXPECT_EQ(buffer.data, storage + i);
+    }
+    EXPECT_FALSE(queue.pop(buffer));
+}
+
+TEST(BufferQueueTest, ConcurrentProducers) {
+    BufferQueue queue(1024);
+    constexpr int kPerThread = 256;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([&, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                queue.push(DetachedBuffer{nullptr, static_cast<std::size_t>(t * kPerThread + i), 0});
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    std::vector<bool> seen(4 * kPerThread, false);
+    DetachedBuffer buffer;
+    while (queue.pop(buffer)) {
+        seen[buffer.size] = true;
+    }
+    for (bool value : seen) {
+        EXPECT_TRUE(value);
+    }
+}
+
+TEST(BufferPoolTest, AcquireSealRelease) {
+    BufferPool pool(2, 60);
+    EXPECT_EQ(pool.buffer_size(), 64u);
+    Logger first(nullptr, 0);
+    Logger second(nullptr, 0);
+    Logger third(nullptr, 0);
+    ASSERT_TRUE(pool.acquire(first));
+    ASSERT_TRUE(pool.acquire(second));
+    EXPECT_FALSE(pool.acquire(third));
+    EXPECT_EQ(first.remaining_capacity(), 64u);
+
+    first << "hello";
+    ASSERT_TRUE(pool.seal(first));
+    EXPECT_EQ(first.remaining_capacity(), 0u);
+    EXPECT_FALSE(pool.seal(first));
+    EXPECT_TRUE(pool.notifier().wait(1ms));
+
+    DetachedBuffer buffer;
+    ASSERT_TRUE(pool.pop_sealed(buffer));
+    EXPECT_EQ(buffer.size, 6u);
+    EXPECT_STREQ(reinterpret_cast<const char*>(buffer.data), "hello");
+    EXPECT_FALSE(pool.pop_sealed(buffer));
+    pool.release(buffer);
+    EXPECT_TRUE(pool.acquire(third));
+}
+
+TEST(DrainerTest, DrainsSealedBuffers) {
+    BufferPool pool(4, 128);
+    std::mutex mutex;
+    std::string drained;
+    Drainer drainer(pool, [&](const uint8_t* data, std::size_t size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        drained.append(reinterpret_cast<const char*>(data), size);
+    });
+    drainer.start();
+
+    Logger logger(nullptr, 0);
+    for (int i = 0; i < 20; ++i) {
+        while (!pool.acquire(logger)) {
+            std::this_thread::yield();  // all buffers in flight
+        }
+        logger.log(reinterpret_cast<const uint8_t*>("ab"), 2);
+        pool.seal(logger);
+    }
+    drainer.stop();
+    EXPECT_EQ(drainer.drained(), 20u);
+    EXPECT_EQ(drained.size(), 40u);
+}
+
+TEST(DrainerTest, LoggerThresholdSignalsOnce) {
+    alignas(kRecordAlignment) uint8_t buffer[128];
+    Notifier notifier;
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_notifier(&notifier, 32);
+
+    logger.begin_record(Level::Info);
+    logger << "short";
+    logger.end_record();
+    EXPECT_FALSE(notifier.wait(1ms));
+
+    logger.begin_record(Level::Info);
+    logger << "long enough to cross";
+    logger.end_record();
+    EXPECT_TRUE(notifier.wait(1ms));
+    logger << "more";
+    EXPECT_FALSE(notifier.wait(1ms));  // edge-triggered
+
+    logger.reset();  // re-armed
+    logger.log(reinterpret_cast<const uint8_t*>(buffer), 40);
+    EXPECT_TRUE(notifier.wait(1ms));
+
+    logger.set_notifier(nullptr, 0);
+    logger.reset();
+    logger.log(reinterpret_cast<const uint8_t*>(buffer), 40);
+    EXPECT_FALSE(notifier.wait(1ms));
+}
+
+TEST(DrainerTest, LoggerThresholdAlreadyPassed) {
+    alignas(kRecordAlignment) uint8_t buffer[128];
+    Notifier notifier;
+    Logger logger(buffer, sizeof(buffer));
+    logger.log(reinterpret_cast<const uint8_t*>(buffer), 40);
+
+    // Attached late: signals right away instead of waiting for reset()
+    logger.set_notifier(&notifier, 32);
+    EXPECT_TRUE(notifier.wait(1ms));
+    logger << "more";
+    EXPECT_FALSE(notifier.wait(1ms));
+
+    // A record header alone can cross the threshold too
+    logger.reset();
+    logger.log(reinterpret_cast<const uint8_t*>(buffer), 28);
+    logger.begin_record(Level::Info);
+    EXPECT_TRUE(notifier.wait(1ms));
+    logger.end_record();
+}
+
+TEST(FormatDrainerTest, WritesInSealOrder) {
+    BufferPool pool(4, 256);
+    std::string output;
+    std::vector<std::thread::id> writers;
+    FormatDrainer drainer(pool, 3,
+        [](const uint8_t* data, std::size_t size, std::string& out) {
+            RecordReader reader(data, size);
+            RecordView record;
+            while (reader.next(record)) {
+                // Later buffers often finish first
+                std::this_thread::sleep_for(std::chrono::microseconds(100 * (3 - record.tag % 4)));
+                format_text(record.data, record.size, out);
+            }
+        },
+        [&](const char* text, std::size_t size) {
+            output.append(text, size);
+            writers.push_back(std::this_thread::get_id());
+        });
+    drainer.start();
+
+    Logger logger(nullptr, 0);
+    std::string expected;
+    for (uint16_t i = 0; i < 40; ++i) {
+        while (!pool.acquire(logger)) {
+            std::this_thread::yield();  // all buffers in flight
+        }
+        logger.begin_record(Level::Info, i);
+        logger << "buffer" << i;
+        logger.end_record();
+        pool.seal(logger);
+        expected += "info " + std::to_string(i) + ": buffer " + std::to_string(i) + "\n";
+    }
+    drainer.stop();
+    EXPECT_EQ(drainer.written(), 40u);
+    EXPECT_EQ(output, expected);
+    EXPECT_EQ(writers.size(), 40u);
+}
+
+TEST(FormatDrainerTest, StopWithoutWork) {
+    BufferPool pool(2, 64);
+    int writes = 0;
+    FormatDrainer drainer(pool, 2, [](const uint8_t*, std::size_t, std::string&) {},
+                          [&](const char*, std::size_t) { ++writes; });
+    drainer.start();
+    drainer.stop();
+    drainer.stop();
+    EXPECT_EQ(drainer.written(), 0u);
+    EXPECT_EQ(writes, 0);
+}
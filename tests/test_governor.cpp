@@ -0,0 +1,152 @@
+#include "log_buffer/governor.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace log_buffer;
+using namespace std::chrono_literals;
+
+namespace {
+
+int admitted(Governor& governor, Level level, int calls) {
+    int count = 0;
+    for (int i = 0; i < calls; ++i) {
+        count += governor.admit(level);
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(GovernorTest, AdmitsEverythingUnderBudget) {
+    Governor governor;
+    EXPECT_EQ(admitted(governor, Level::Trace, 100), 100);
+    EXPECT_EQ(governor.shed(), 0u);
+    governor.update(0.001);
+    EXPECT_EQ(governor.sampling_shift(), 0u);
+    EXPECT_EQ(governor.floor(), Level::Trace);
+}
+
+TEST(GovernorTest, EscalatesSamplingThenFloor) {
+    GovernorConfig config;
+    config.max_sampling_shift = 2;
+    Governor governor(config);
+
+    governor.update(0.5);
+    EXPECT_EQ(governor.sampling_shift(), 1u);
+    EXPECT_EQ(admitted(governor, Level::Debug, 1000), 500);
+    governor.update(0.5);
+    EXPECT_EQ(governor.sampling_shift(), 2u);
+    EXPECT_EQ(admitted(governor, Level::Debug, 1000), 250);
+
+    governor.update(0.5);  // sampling maxed out: raise the floor
+    EXPECT_EQ(governor.floor(), Level::Debug);
+    EXPECT_EQ(admitted(governor, Level::Trace, 100), 0);
+    for (int i = 0; i < 10; ++i) {
+        governor.update(0.5);
+    }
+    EXPECT_EQ(governor.floor(), Level::Warn);  // never above protected_level
+    EXPECT_EQ(admitted(governor, Level::Info, 100), 0);
+    EXPECT_EQ(admitted(governor, Level::Warn, 100), 100);
+    EXPECT_EQ(admitted(governor, Level::Fatal, 100), 100);
+    EXPECT_GT(governor.shed(), 0u);
+}
+
+TEST(GovernorTest, RelaxesWithHysteresis) {
+    GovernorConfig config;
+    config.budget = 0.02;
+    config.max_sampling_shift = 1;
+    Governor governor(config);
+    governor.update(0.1);
+    governor.update(0.1);
+    ASSERT_EQ(governor.sampling_shift(), 1u);
+    ASSERT_EQ(governor.floor(), Level::Debug);
+
+    governor.update(0.015);  // under budget but above budget * relax_below: hold
+    EXPECT_EQ(governor.floor(), Level::Debug);
+    governor.update(0.005);  // relax in reverse order: floor first, then sampling
+    EXPECT_EQ(governor.floor(), Level::Trace);
+    EXPECT_EQ(governor.sampling_shift(), 1u);
+    governor.update(0.005);
+    EXPECT_EQ(governor.sampling_shift(), 0u);
+    EXPECT_EQ(admitted(governor, Level::Trace, 10), 10);
+}
+
+TEST(GovernorTest, MeasuresTimeInScopes) {
+    GovernorConfig config;
+    config.interval = 1ms;
+    config.sample_every = 1;
+    Governor governor(config);
+
+    // Spend all the time inside timed writes: far over a 2% budget
+    const auto end = std::chrono::steady_clock::now() + 20ms;
+    while (std::chrono::steady_clock::now() < end) {
+        if (governor.admit(Level::Warn)) {
+            Governor::Scope timed(governor);
+            const auto busy = std::chrono::steady_clock::now() + 100us;
+            while (std::chrono::steady_clock::now() < busy) {
+            }
+        }
+    }
+    EXPECT_GT(governor.load(), config.budget);
+    EXPECT_GT(governor.sampling_shift(), 0u);
+}
+
+TEST(GovernorTest, RelaxesAfterQuietSpell) {
+    GovernorConfig config;
+    config.interval = 1ms;
+    config.sample_every = 1;
+    config.max_sampling_shift = 3;
+    Governor governor(config);
+    for (int i = 0; i < 5; ++i) {
+        governor.update(1.0);
+    }
+    ASSERT_EQ(governor.floor(), Level::Info);
+
+    // Cheap writes after a long pause: one boundary check relaxes several steps
+    std::this_thread::sleep_for(20ms);
+    {
+        Governor::Scope timed(governor);
+    }
+    EXPECT_LT(governor.load(), config.budget * config.relax_below);
+    EXPECT_EQ(governor.floor(), Level::Trace);
+    EXPECT_EQ(governor.sampling_shift(), 0u);
+}
+
+TEST(GovernorTest, RelaxesWhileSheddingEverything) {
+    GovernorConfig config;
+    config.interval = 1ms;
+    config.sample_every = 16;
+    config.max_sampling_shift = 2;
+    Governor governor(config);
+    for (int i = 0; i < 10; ++i) {
+        governor.update(1.0);
+    }
+    ASSERT_EQ(governor.floor(), Level::Warn);
+
+    // Every call below Warn is shed, so no Scope runs; shed calls must still end intervals
+    std::this_thread::sleep_for(20ms);
+    int count = 0;
+    for (int i = 0; i < 1000; ++i) {
+        if (governor.admit(i % 2 == 0 ? Level::Debug : Level::Info)) {
+            Governor::Scope timed(governor);
+            ++count;
+        }
+    }
+    EXPECT_EQ(governor.floor(), Level::Trace);
+    EXPECT_EQ(governor.sampling_shift(), 0u);
+    EXPECT_GT(count, 0);
+}
+
+TEST(GovernorTest, ZeroIntervalIsClamped) {
+    GovernorConfig config;
+    config.interval = 0ns;
+    config.sample_every = 1;
+    Governor governor(config);
+    EXPECT_EQ(governor.config().interval, 1ns);
+    for (int i = 0; i < 100; ++i) {
+        if (governor.admit(Level::Info)) {
+            Governor::Scope timed(governor);
+        }
+    }
+    EXPECT_GE(governor.load(), 0.0);
+}
@@ -0,0 +1,125 @@
+#include "log_buffer/level_table.hpp"
+#include "log_buffer/logger.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace log_buffer;
+
+TEST(LevelTableTest, LevelsFrom) {
+    EXPECT_EQ(levels_from(Level::Trace), 0x3F);
+    EXPECT_EQ(levels_from(Level::Info), 0x3C);
+    EXPECT_EQ(levels_from(Level::Fatal), 0x20);
+}
+
+TEST(LevelTableTest, LocalDefaults) {
+    LevelTable table;
+    EXPECT_FALSE(table.is_open());
+    ASSERT_TRUE(table.open_local());
+    
+    EXPECT_FALSE(table.enabled(0, Level::Debug));
+    EXPECT_TRUE(table.enabled(0, Level::Info));
+    EXPECT_TRUE(table.enabled(65535, Level::Fatal));
+}
+
+TEST(LevelTableTest, PerTagLevels) {
+    LevelTable table;
+    ASSERT_TRUE(table.open_local());
+    
+    table.set_min_level(42, Level::Trace);
+    EXPECT_TRUE(table.enabled(42, Level::Trace));
+    EXPECT_FALSE(table.enabled(43, Level::Trace));
+    
+    table.set_levels(7, 0);
+    EXPECT_FALSE(table.enabled(7, Level::Fatal));
+    
+    table.set_all(levels_from(Level::Error));
+    EXPECT_FALSE(table.enabled(42, Level::Warn));
+    EXPECT_TRUE(table.enabled(42, Level::Error));
+}
+
+TEST(LevelTableTest, GatesFormatting) {
+    LevelTable table;
+    ASSERT_TRUE(table.open_local());
+    uint8_t buffer[64];
+    Logger logger(buffer, sizeof(buffer));
+    
+    for (Level level : {Level::Debug, Level::Warn}) {
+        if (table.enabled(1, level)) {
+            logger.begin_record(level, 1);
+            logger << "value " << 5;
+            logger.end_record();
+        }
+    }
+    EXPECT_EQ(logger.bytes_written(), align_record(sizeof(RecordHeader) + 7 + 2));
+}
+
+TEST(LevelTableTest, SharedBetweenMappings) {
+    const std::string name = "/log_buffer_test." + std::to_string(::getpid());
+    LevelTable::remove(name.c_str());
+    
+    LevelTable missing;
+    EXPECT_FALSE(missing.open(name.c_str(), false));
+    
+    LevelTable writer;
+    ASSERT_TRUE(writer.open(name.c_str(), true));
+    LevelTable reader;
+    ASSERT_TRUE(reader.open(name.c_str(), false));
+    
+    EXPECT_FALSE(reader.enabled(9, Level::Debug));
+    writer.set_min_level(9, Level::Debug);
+    EXPECT_TRUE(reader.enabled(9, Level::Debug));
+    
+    // Opening with create on an existing table attaches without resetting it
+    LevelTable again;
+    ASSERT_TRUE(again.open(name.c_str(), true));
+    EXPECT_TRUE(again.enabled(9, Level::Debug));
+    
+    EXPECT_TRUE(LevelTable::remove(name.c_str()));
+}
+
+TEST(LevelTableTest, AttachWaitsForCreator) {
+    const std::string name = "/log_buffer_race." + std::to_string(::getpid());
+    LevelTable::remove(name.c_str());
+    
+    // Play a creator that is slow between shm_open, ftruncate and publishing the magic
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+    ASSERT_GE(fd, 0);
+    std::thread creator([fd] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ASSERT_EQ(::ftruncate(fd, sizeof(LevelControlBlock)), 0);
+        void* mapping = ::mmap(nullptr, sizeof(LevelControlBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ASSERT_NE(mapping, MAP_FAILED);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto* block = static_cast<LevelControlBlock*>(mapping);
+        for (auto& mask : block->levels) {
+            mask.store(kDefaultLevelMask, std::memory_order_relaxed);
+        }
+        block->version = kLevelTableVersion;
+        block->magic.store(kLevelTableMagic, std::memory_order_release);
+        ::munmap(mapping, sizeof(LevelControlBlock));
+    });
+    
+    LevelTable attacher;
+    EXPECT_TRUE(attacher.open(name.c_str(), true));
+    creator.join();
+    ::close(fd);
+    EXPECT_TRUE(attacher.enabled(1, Level::Info));
+    EXPECT_FALSE(attacher.enabled(1, Level::Debug));
+    EXPECT_TRUE(LevelTable::remove(name.c_str()));
+}
+
+TEST(LevelTableTest, Move) {
+    LevelTable table;
+    ASSERT_TRUE(table.open_local());
+    table.set_min_level(3, Level::Trace);
+    
+    LevelTable moved(std::move(table));
+    EXPECT_FALSE(table.is_open());
+    ASSERT_TRUE(moved.is_open());
+    EXPECT_TRUE(moved.enabled(3, Level::Trace));
+}
@@ -2,6 +2,8 @@
 #include <gtest/gtest.h>
 #include <ios>
 #include <cstring>
+#include <string>
+#include <vector>
 
 using namespace log_buffer;
 using log_buffer::BinaryData;  // Allow using BinaryData without namespace prefix
@@ -443,3 +445,832 @@ TEST_F(LoggerTest, StdManipulatorMixedWithStrings) {
     ptr += sizeof("0xff");
     EXPECT_STREQ(ptr, " End");
 }
+
+TEST_F(LoggerTest, StringFormatDefault) {
+    Logger logger(buffer, sizeof(buffer));
+    EXPECT_EQ(logger.get_string_format(), StringFormat::NulTerminated);
+}
+
+TEST_F(LoggerTest, LengthPrefixedString) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_string_format(StringFormat::LengthPrefixed);
+    
+    EXPECT_TRUE(logger.log("Hello"));
+    EXPECT_EQ(logger.bytes_written(), 6); // 1 length byte + 5 chars
+    EXPECT_EQ(buffer[0], 5);
+    EXPECT_EQ(std::memcmp(buffer + 1, "Hello", 5), 0);
+}
+
+TEST_F(LoggerTest, LengthPrefixedEmbeddedNul) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_string_format(StringFormat::LengthPrefixed);
+    
+    const std::string_view with_nul("a\0b", 3);
+    EXPECT_TRUE(logger.log(with_nul));
+    EXPECT_TRUE(logger.log("next"));
+    
+    const uint8_t* p = logger.data();
+    const uint8_t* end = p + logger.bytes_written();
+    std::string_view field;
+    p = decode_string(p, end, field);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(field, with_nul);
+    p = decode_string(p, end, field);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(field, "next");
+    EXPECT_EQ(p, end);
+}
+
+TEST_F(LoggerTest, LengthPrefixedInteger) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_string_format(StringFormat::LengthPrefixed);
+    
+    logger << std::hex << 255;
+    EXPECT_EQ(logger.bytes_written(), 5); // 1 length byte + "0xff"
+    EXPECT_EQ(buffer[0], 4);
+    EXPECT_EQ(std::memcmp(buffer + 1, "0xff", 4), 0);
+}
+
+TEST_F(LoggerTest, LengthPrefixedLongString) {
+    uint8_t big_buffer[300];
+    Logger logger(big_buffer, sizeof(big_buffer));
+    logger.set_string_format(StringFormat::LengthPrefixed);
+    
+    const std::string long_str(200, 'x');
+    EXPECT_TRUE(logger.log(long_str));
+    EXPECT_EQ(logger.bytes_written(), 202); // 2-byte varint + 200 chars
+    
+    std::string_view field;
+    const uint8_t* end = big_buffer + logger.bytes_written();
+    EXPECT_EQ(decode_string(big_buffer, end, field), end);
+    EXPECT_EQ(field, long_str);
+}
+
+TEST_F(LoggerTest, LengthPrefixedOverflow) {
+    uint8_t small_buffer[6];
+    Logger logger(small_buffer, sizeof(small_buffer));
+    logger.set_string_format(StringFormat::LengthPrefixed);
+    
+    EXPECT_TRUE(logger.log("Hello")); // exactly fills the buffer
+    EXPECT_FALSE(logger.has_overflowed());
+    EXPECT_FALSE(logger.log(""));
+    EXPECT_TRUE(logger.has_overflowed());
+    EXPECT_EQ(logger.bytes_written(), 6);
+}
+
+TEST(EncodingTest, VarintRoundTrip) {
+    uint8_t out[kMaxVarintSize];
+    for (uint64_t value : {0ULL, 1ULL, 127ULL, 128ULL, 300ULL, 0xFFFFFFFFULL, ~0ULL}) {
+        uint8_t* end = encode_varint(out, value);
+        EXPECT_EQ(static_cast<std::size_t>(end - out), varint_size(value));
+        uint64_t decoded = 0;
+        EXPECT_EQ(decode_varint(out, end, decoded), end);
+        EXPECT_EQ(decoded, value);
+    }
+}
+
+TEST(EncodingTest, DecodeStringTruncated) {
+    const uint8_t data[] = {5, 'a', 'b'};
+    std::string_view field;
+    EXPECT_EQ(decode_string(data, data + sizeof(data), field), nullptr);
+    
+    const uint8_t unterminated[] = {0x80, 0x80};
+    uint64_t value = 0;
+    EXPECT_EQ(decode_varint(unterminated, unterminated + sizeof(unterminated), value), nullptr);
+}
+
+TEST_F(LoggerTest, BoundedStringFits) {
+    Logger logger(buffer, sizeof(buffer));
+    
+    EXPECT_TRUE(logger.log("Hello", 5));
+    EXPECT_STREQ(reinterpret_cast<const char*>(buffer), "Hello");
+    EXPECT_EQ(logger.bytes_written(), 6);
+}
+
+TEST_F(LoggerTest, BoundedStringTruncated) {
+    Logger logger(buffer, sizeof(buffer));
+    
+    EXPECT_TRUE(logger.log("Hello, World!", 5));
+    EXPECT_STREQ(reinterpret_cast<const char*>(buffer), "Hello...");
+    EXPECT_EQ(logger.bytes_written(), 9); // 5 chars + marker + null
+}
+
+TEST_F(LoggerTest, BoundedStringLengthPrefixed) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_string_format(StringFormat::LengthPrefixed);
+    
+    EXPECT_TRUE(logger.log(std::string("abcdefgh"), 2));
+    std::string_view field;
+    const uint8_t* end = buffer + logger.bytes_written();
+    EXPECT_EQ(decode_string(buffer, end, field), end);
+    EXPECT_EQ(field, "ab...");
+}
+
+TEST_F(LoggerTest, MaxFieldLength) {
+    Logger logger(buffer, sizeof(buffer));
+    EXPECT_EQ(logger.get_max_field_length(), kNoFieldLimit);
+    
+    logger.set_max_field_length(4);
+    logger << "Hi" << "Overlong" << std::string("Truncated") << 123456789;
+    
+    const char* ptr = reinterpret_cast<const char*>(buffer);
+    EXPECT_STREQ(ptr, "Hi");
+    ptr += sizeof("Hi");
+    EXPECT_STREQ(ptr, "Over...");
+    ptr += sizeof("Over...");
+    EXPECT_STREQ(ptr, "Trun...");
+    ptr += sizeof("Trun...");
+    EXPECT_STREQ(ptr, "123456789"); // Integers are never truncated
+}
+
+TEST_F(LoggerTest, MaxFieldLengthKeepsBufferUsable) {
+    uint8_t small_buffer[16];
+    Logger logger(small_buffer, sizeof(small_buffer));
+    logger.set_max_field_length(4);
+    
+    const std::string huge(1000, 'z');
+    EXPECT_TRUE(logger.log(huge));
+    EXPECT_FALSE(logger.has_overflowed());
+    EXPECT_TRUE(logger.log("ok"));
+    EXPECT_EQ(logger.bytes_written(), 11); // "zzzz..." + null, "ok" + null
+}
+
+TEST_F(LoggerTest, Utf16Ascii) {
+    Logger logger(buffer, sizeof(buffer));
+    
+    // Long enough to exercise the vectorized ASCII path plus a scalar tail
+    EXPECT_TRUE(logger.log(u"Hello, wide world!"));
+    EXPECT_STREQ(reinterpret_cast<const char*>(buffer), "Hello, wide world!");
+    EXPECT_EQ(logger.bytes_written(), sizeof("Hello, wide world!"));
+}
+
+TEST_F(LoggerTest, Utf16MultiByte) {
+    Logger logger(buffer, sizeof(buffer));
+    
+    // e-acute (2 bytes), euro sign (3 bytes), U+1F600 as a surrogate pair (4 bytes)
+    EXPECT_TRUE(logger.log(std::u16string(u"café € \U0001F600 and more ascii")));
+    EXPECT_STREQ(reinterpret_cast<const char*>(buffer),
+                 "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 and more ascii");
+}
+
+TEST_F(LoggerTest, Utf16LoneSurrogate) {
+    Logger logger(buffer, sizeof(buffer));
+    
+    const char16_t units[] = {u'a', 0xD800, u'b', 0xDC00};
+    EXPECT_TRUE(logger.log(std::u16string_view(units, 4)));
+    EXPECT_STREQ(reinterpret_cast<const char*>(buffer), "a\xEF\xBF\xBD" "b\xEF\xBF\xBD");
+}
+
+TEST_F(LoggerTest, Utf32) {
+    Logger logger(buffer, sizeof(buffer));
+    
+    const char32_t units[] = {U'A', 0x00E9, 0x1F600, 0x110000, U'Z'};
+    EXPECT_TRUE(logger.log(std::u32string_view(units, 5)));
+    EXPECT_STREQ(reinterpret_cast<const char*>(buffer), "A\xC3\xA9\xF0\x9F\x98\x80\xEF\xBF\xBDZ");
+    
+    logger.reset();
+    EXPECT_TRUE(logger.log(U"plain ascii utf-32 text"));
+    EXPECT_STREQ(reinterpret_cast<const char*>(buffer), "plain ascii utf-32 text");
+}
+
+TEST_F(LoggerTest, WideString) {
+    Logger logger(buffer, sizeof(buffer));
+    
+    logger << L"wide " << std::wstring(L"é");
+    const char* ptr = reinterpret_cast<const char*>(buffer);
+    EXPECT_STREQ(ptr, "wide ");
+    ptr += sizeof("wide ");
+    EXPECT_STREQ(ptr, "\xC3\xA9");
+}
+
+TEST_F(LoggerTest, Utf16LengthPrefixed) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_string_format(StringFormat::LengthPrefixed);
+    
+    // 50 units have a 150-byte bound that does not fit, so the exact length
+    // (50 bytes, 1-byte prefix) is used
+    EXPECT_TRUE(logger.log(std::u16string(50, u'x')));
+    EXPECT_EQ(logger.bytes_written(), 51);
+    EXPECT_EQ(buffer[0], 50);
+}
+
+TEST_F(LoggerTest, Utf16LengthPrefixedPaddedPrefix) {
+    uint8_t big_buffer[300];
+    Logger logger(big_buffer, sizeof(big_buffer));
+    logger.set_string_format(StringFormat::LengthPrefixed);
+    
+    // 64 units have a 192-byte bound, so a 2-byte prefix is reserved and the
+    // actual 64-byte length is written padded to that width
+    EXPECT_TRUE(logger.log(std::u16string(64, u'y')));
+    EXPECT_TRUE(logger.log(u"\u20AC"));
+    EXPECT_EQ(logger.bytes_written(), 2 + 64 + 1 + 3);
+    
+    std::string_view field;
+    const uint8_t* end = big_buffer + logger.bytes_written();
+    const uint8_t* p = decode_string(big_buffer, end, field);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(field, std::string(64, 'y'));
+    EXPECT_EQ(decode_string(p, end, field), end);
+    EXPECT_EQ(field, "\xE2\x82\xAC");
+}
+
+TEST_F(LoggerTest, Utf16ExactFitBeyondBound) {
+    uint8_t small_buffer[6];
+    Logger logger(small_buffer, sizeof(small_buffer));
+    
+    // Bound is 15 bytes, actual UTF-8 is 5 + null
+    EXPECT_TRUE(logger.log(u"abcde"));
+    EXPECT_FALSE(logger.has_overflowed());
+    EXPECT_FALSE(logger.log(u"x"));
+    EXPECT_TRUE(logger.has_overflowed());
+    EXPECT_EQ(logger.bytes_written(), 6);
+}
+
+TEST_F(LoggerTest, RecordFraming) {
+    Logger logger(buffer, sizeof(buffer));
+    
+    EXPECT_TRUE(logger.begin_record(Level::Warn, 7));
+    EXPECT_TRUE(logger.log("disk"));
+    EXPECT_TRUE(logger.log(90));
+    EXPECT_TRUE(logger.end_record());
+    
+    RecordHeader header;
+    std::memcpy(&header, buffer, sizeof(header));
+    EXPECT_EQ(header.size, sizeof(RecordHeader) + 5 + 3);
+    EXPECT_EQ(header.type, static_cast<uint8_t>(RecordType::Log));
+    EXPECT_EQ(header.level, static_cast<uint8_t>(Level::Warn));
+    EXPECT_EQ(header.tag, 7);
+    EXPECT_STREQ(reinterpret_cast<const char*>(buffer + sizeof(RecordHeader)), "disk");
+    EXPECT_EQ(logger.bytes_written(), align_record(header.size));
+}
+
+TEST_F(LoggerTest, RecordAlignsAfterRawWrites) {
+    Logger logger(buffer, sizeof(buffer));
+    
+    logger.log("abc"); // 4 bytes, leaves the position unaligned
+    EXPECT_TRUE(logger.begin_record(Level::Info));
+    EXPECT_TRUE(logger.end_record());
+    EXPECT_EQ(buffer[4], 0); // gap is zero-filled
+    EXPECT_EQ(logger.bytes_written(), 2 * kRecordAlignment);
+}
+
+TEST_F(LoggerTest, RecordNestingRejected) {
+    Logger logger(buffer, sizeof(buffer));
+    
+    EXPECT_TRUE(logger.begin_record(Level::Info));
+    EXPECT_FALSE(logger.begin_record(Level::Info));
+    EXPECT_TRUE(logger.end_record());
+    EXPECT_FALSE(logger.end_record());
+}
+
+TEST_F(LoggerTest, RecordDiscardedOnOverflow) {
+    uint8_t small_buffer[32];
+    Logger logger(small_buffer, sizeof(small_buffer));
+    
+    EXPECT_TRUE(logger.begin_record(Level::Info));
+    EXPECT_TRUE(logger.log("ok"));
+    EXPECT_TRUE(logger.end_record());
+    const std::size_t committed = logger.bytes_written();
+    
+    EXPECT_TRUE(logger.begin_record(Level::Info));
+    EXPECT_TRUE(logger.log("a"));
+    EXPECT_FALSE(logger.log("too long to fit"));
+    EXPECT_FALSE(logger.end_record());
+    EXPECT_TRUE(logger.has_overflowed());
+    EXPECT_EQ(logger.bytes_written(), committed);
+    
+    // A header that does not fit still pairs with end_record()
+    EXPECT_TRUE(logger.begin_record(Level::Info));
+    EXPECT_TRUE(logger.end_record());
+    EXPECT_TRUE(logger.begin_record(Level::Info));
+    EXPECT_TRUE(logger.end_record());
+    EXPECT_FALSE(logger.begin_record(Level::Info));
+    EXPECT_FALSE(logger.end_record());
+    EXPECT_EQ(logger.bytes_written(), sizeof(small_buffer));
+}
+
+TEST_F(LoggerTest, NotCopyable) {
+    static_assert(!std::is_copy_constructible_v<Logger>, "Logger must not be copyable");
+    static_assert(!std::is_copy_assignable_v<Logger>, "Logger must not be copyable");
+    static_assert(std::is_nothrow_move_constructible_v<Logger>, "Logger must be movable");
+    static_assert(std::is_nothrow_move_assignable_v<Logger>, "Logger must be movable");
+}
+
+TEST_F(LoggerTest, MoveConstruct) {
+    Logger source(buffer, sizeof(buffer));
+    source << std::hex << "moved";
+    
+    Logger target(std::move(source));
+    EXPECT_EQ(target.data(), buffer);
+    EXPECT_EQ(target.bytes_written(), 6);
+    EXPECT_EQ(target.get_int_format(), IntFormat::Hex);
+    
+    // The moved-from logger has no buffer and rejects writes
+    EXPECT_EQ(source.remaining_capacity(), 0);
+    EXPECT_FALSE(source.log("x"));
+    EXPECT_TRUE(source.has_overflowed());
+}
+
+TEST_F(LoggerTest, MoveAssign) {
+    uint8_t other_buffer[16];
+    Logger source(buffer, sizeof(buffer));
+    Logger target(other_buffer, sizeof(other_buffer));
+    source.log("abc");
+    
+    target = std::move(source);
+    EXPECT_EQ(target.data(), buffer);
+    EXPECT_EQ(target.bytes_written(), 4);
+    EXPECT_EQ(source.data(), nullptr);
+}
+
+TEST_F(LoggerTest, Swap) {
+    uint8_t other_buffer[16];
+    Logger a(buffer, sizeof(buffer));
+    Logger b(other_buffer, sizeof(other_buffer));
+    a.log("a");
+    
+    swap(a, b);
+    EXPECT_EQ(a.data(), other_buffer);
+    EXPECT_EQ(a.bytes_written(), 0);
+    EXPECT_EQ(b.data(), buffer);
+    EXPECT_EQ(b.bytes_written(), 2);
+}
+
+TEST_F(LoggerTest, DetachAndAttach) {
+    uint8_t spare[32];
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_string_format(StringFormat::LengthPrefixed);
+    logger.log("full");
+    
+    const DetachedBuffer filled = logger.detach();
+    EXPECT_EQ(filled.data, buffer);
+    EXPECT_EQ(filled.size, 5);
+    EXPECT_EQ(filled.capacity, sizeof(buffer));
+    EXPECT_EQ(logger.data(), nullptr);
+    
+    logger.attach(spare, sizeof(spare));
+    EXPECT_EQ(logger.bytes_written(), 0);
+    EXPECT_EQ(logger.remaining_capacity(), sizeof(spare));
+    EXPECT_EQ(logger.get_string_format(), StringFormat::LengthPrefixed);
+    EXPECT_TRUE(logger.log("next"));
+    EXPECT_EQ(spare[0], 4);
+}
+
+TEST_F(LoggerTest, DetachDropsOpenRecord) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.begin_record(Level::Info);
+    logger.log("done");
+    logger.end_record();
+    const std::size_t committed = logger.bytes_written();
+    
+    logger.begin_record(Level::Info);
+    logger.log("partial");
+    const DetachedBuffer filled = logger.detach();
+    EXPECT_EQ(filled.size, committed);
+    EXPECT_FALSE(logger.end_record());
+    EXPECT_EQ(logger.dropped_records(), 1);
+    EXPECT_EQ(logger.dropped_bytes(), sizeof(RecordHeader) + 8);
+}
+
+TEST_F(LoggerTest, GapRecordReportsDetachedRecord) {
+    uint8_t next[64];
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_gap_records(true);
+    logger.begin_record(Level::Info);
+    logger.log("partial");
+    logger.detach();
+    
+    logger.attach(next, sizeof(next));
+    EXPECT_EQ(logger.dropped_records(), 0);
+    RecordHeader header;
+    std::memcpy(&header, next, sizeof(header));
+    EXPECT_EQ(header.type, static_cast<uint8_t>(RecordType::Gap));
+    EXPECT_EQ(next[sizeof(RecordHeader)], 1); // one record
+}
+
+TEST_F(LoggerTest, ChildWritesIntoParentRegion) {
+    Logger parent(buffer, sizeof(buffer));
+    Logger child = parent.child(16);
+    EXPECT_EQ(child.data(), buffer);
+    EXPECT_EQ(child.remaining_capacity(), 16);
+    EXPECT_EQ(parent.bytes_written(), 16);
+    
+    child << std::hex << 255;
+    EXPECT_STREQ(reinterpret_cast<const char*>(buffer), "0xff");
+    EXPECT_EQ(parent.get_int_format(), IntFormat::Dec);
+}
+
+TEST_F(LoggerTest, ChildInheritsSettings) {
+    Logger parent(buffer, sizeof(buffer));
+    parent.set_string_format(StringFormat::LengthPrefixed).set_int_format(IntFormat::Oct);
+    Logger child = parent.child(8);
+    EXPECT_EQ(child.get_string_format(), StringFormat::LengthPrefixed);
+    EXPECT_EQ(child.get_int_format(), IntFormat::Oct);
+}
+
+TEST_F(LoggerTest, ChildCloseReturnsUnusedSpace) {
+    Logger parent(buffer, sizeof(buffer));
+    parent.log("head");
+    Logger child = parent.child(40);
+    EXPECT_EQ(child.data(), buffer + kRecordAlignment);
+    EXPECT_EQ(parent.bytes_written(), kRecordAlignment + 40);
+    
+    child.log("abc");
+    EXPECT_TRUE(child.close());
+    EXPECT_EQ(parent.bytes_written(), 2 * kRecordAlignment);
+    EXPECT_EQ(child.data(), nullptr);
+    EXPECT_FALSE(child.close());
+}
+
+TEST_F(LoggerTest, ChildCloseFillsWhenNotLast) {
+    std::memset(buffer, 0xAA, sizeof(buffer));
+    Logger parent(buffer, sizeof(buffer));
+    Logger first = parent.child(16);
+    Logger second = parent.child(16);
+    
+    first.log("a");
+    EXPECT_TRUE(first.close());
+    EXPECT_EQ(parent.bytes_written(), 32);
+    for (std::size_t i = 2; i < 16; ++i) {
+        EXPECT_EQ(buffer[i], 0) << "at " << i;
+    }
+    
+    EXPECT_TRUE(second.close());
+    EXPECT_EQ(parent.bytes_written(), 16); // second was last, so all of it comes back
+}
+
+TEST_F(LoggerTest, ChildTooLarge) {
+    Logger parent(buffer, sizeof(buffer));
+    Logger child = parent.child(sizeof(buffer) + 1);
+    EXPECT_TRUE(parent.has_overflowed());
+    EXPECT_EQ(parent.bytes_written(), 0);
+    EXPECT_EQ(child.remaining_capacity(), 0);
+    EXPECT_FALSE(child.log("x"));
+    EXPECT_FALSE(child.close());
+}
+
+TEST_F(LoggerTest, ChildRefusedInsideOpenRecord) {
+    Logger parent(buffer, sizeof(buffer));
+    parent.begin_record(Level::Info);
+    parent.log("outer");
+    const std::size_t written = parent.bytes_written();
+    
+    Logger child = parent.child(16);
+    EXPECT_TRUE(parent.has_overflowed());
+    EXPECT_EQ(child.data(), nullptr);
+    EXPECT_EQ(parent.bytes_written(), written);
+    EXPECT_FALSE(child.log("x"));
+    EXPECT_FALSE(child.close());
+    
+    // The parent's record is discarded rather than framing anything else
+    EXPECT_FALSE(parent.end_record());
+    EXPECT_EQ(parent.bytes_written(), 0);
+}
+
+TEST_F(LoggerTest, AppendLogger) {
+    uint8_t other_buffer[32];
+    Logger logger(buffer, sizeof(buffer));
+    Logger other(other_buffer, sizeof(other_buffer));
+    logger.log("one");
+    other.log("two");
+    other.log(3);
+    
+    EXPECT_TRUE(logger.append(other));
+    EXPECT_EQ(logger.bytes_written(), 4 + 4 + 2);
+    const char* ptr = reinterpret_cast<const char*>(buffer);
+    EXPECT_STREQ(ptr, "one");
+    EXPECT_STREQ(ptr + 4, "two");
+    EXPECT_STREQ(ptr + 8, "3");
+}
+
+TEST_F(LoggerTest, AppendExcludesOpenRecord) {
+    uint8_t other_buffer[64];
+    Logger logger(buffer, sizeof(buffer));
+    Logger other(other_buffer, sizeof(other_buffer));
+    other.begin_record(Level::Info);
+    other.log("complete");
+    other.end_record();
+    const std::size_t committed = other.bytes_written();
+    other.begin_record(Level::Info);
+    other.log("open");
+    
+    EXPECT_TRUE(logger.append(other));
+    EXPECT_EQ(logger.bytes_written(), committed);
+    EXPECT_EQ(std::memcmp(buffer, other_buffer, committed), 0);
+}
+
+TEST_F(LoggerTest, AppendRangeOverflow) {
+    const uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t small_buffer[12];
+    Logger logger(small_buffer, sizeof(small_buffer));
+    
+    EXPECT_TRUE(logger.append_range(data, data + 8));
+    EXPECT_FALSE(logger.append_range(data, data + 8));
+    EXPECT_TRUE(logger.has_overflowed());
+    EXPECT_EQ(logger.bytes_written(), 8);
+    EXPECT_TRUE(logger.append_range(data, data)); // empty range always fits
+}
+
+TEST_F(LoggerTest, AppendRangeLarge) {
+    // Large enough for the non-temporal path, with an odd offset on both sides
+    std::vector<uint8_t> source(kStreamingCopyThreshold + 123);
+    for (std::size_t i = 0; i < source.size(); ++i) {
+        source[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    std::vector<uint8_t> target(source.size() + 16);
+    Logger logger(target.data(), target.size());
+    logger.log("x");
+    
+    EXPECT_TRUE(logger.append_range(source.data() + 1, source.data() + source.size()));
+    EXPECT_EQ(logger.bytes_written(), 2 + source.size() - 1);
+    EXPECT_EQ(std::memcmp(target.data() + 2, source.data() + 1, source.size() - 1), 0);
+}
+
+TEST_F(LoggerTest, DroppedCountsOutsideRecords) {
+    uint8_t small_buffer[8];
+    Logger logger(small_buffer, sizeof(small_buffer));
+    
+    EXPECT_TRUE(logger.log("abc"));
+    EXPECT_FALSE(logger.log("too long"));
+    EXPECT_FALSE(logger.log(12345));
+    EXPECT_EQ(logger.dropped_records(), 2);
+    EXPECT_EQ(logger.dropped_bytes(), 9 + 6);
+    
+    // Without gap records, reset() keeps the counts and writes nothing
+    logger.reset();
+    EXPECT_EQ(logger.bytes_written(), 0);
+    EXPECT_EQ(logger.dropped_records(), 2);
+}
+
+TEST_F(LoggerTest, DroppedRecordCountedOnce) {
+    uint8_t small_buffer[24];
+    Logger logger(small_buffer, sizeof(small_buffer));
+    
+    logger.begin_record(Level::Info);
+    logger.log("0123456789");
+    logger.log("0123456789");
+    logger.log("0123456789");
+    EXPECT_FALSE(logger.end_record());
+    EXPECT_EQ(logger.dropped_records(), 1);
+    EXPECT_EQ(logger.dropped_bytes(), sizeof(RecordHeader) + 3 * 11);
+}
+
+TEST_F(LoggerTest, GapRecordOnReset) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_gap_records(true);
+    EXPECT_TRUE(logger.get_gap_records());
+    
+    const std::string big(200, 'x');
+    EXPECT_FALSE(logger.log(big));
+    logger.reset();
+    
+    RecordHeader header;
+    std::memcpy(&header, buffer, sizeof(header));
+    EXPECT_EQ(header.type, static_cast<uint8_t>(RecordType::Gap));
+    EXPECT_EQ(header.size, sizeof(RecordHeader) + 1 + 2);
+    EXPECT_EQ(buffer[sizeof(RecordHeader)], 1); // one record
+    uint64_t bytes = 0;
+    decode_varint(buffer + sizeof(RecordHeader) + 1, buffer + header.size, bytes);
+    EXPECT_EQ(bytes, 201);
+    EXPECT_EQ(logger.bytes_written(), align_record(header.size));
+    EXPECT_EQ(logger.dropped_records(), 0);
+    EXPECT_FALSE(logger.has_overflowed());
+    
+    // No loss, no gap record
+    logger.reset();
+    EXPECT_EQ(logger.bytes_written(), 0);
+}
+
+TEST_F(LoggerTest, GapRecordOnAttach) {
+    uint8_t first[8];
+    Logger logger(first, sizeof(first));
+    logger.set_gap_records(true);
+    EXPECT_FALSE(logger.log("overflowing"));
+    
+    const DetachedBuffer full = logger.detach();
+    EXPECT_EQ(full.size, 0);
+    EXPECT_EQ(logger.dropped_records(), 1); // nowhere to write it yet
+    
+    logger.attach(buffer, sizeof(buffer));
+    EXPECT_EQ(logger.dropped_records(), 0);
+    RecordHeader header;
+    std::memcpy(&header, buffer, sizeof(header));
+    EXPECT_EQ(header.type, static_cast<uint8_t>(RecordType::Gap));
+}
+
+TEST_F(LoggerTest, SequenceNumbersDeltaEncoded) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_sequence_numbers(true).set_next_sequence(1000);
+    EXPECT_TRUE(logger.get_sequence_numbers());
+    
+    logger.begin_record(Level::Info);
+    logger.end_record();
+    logger.begin_record(Level::Info);
+    logger.end_record();
+    
+    // First record: absolute 1000 (2-byte varint); second: delta 1 (1 byte)
+    RecordHeader header;
+    std::memcpy(&header, buffer, sizeof(header));
+    EXPECT_EQ(header.type, static_cast<uint8_t>(RecordType::Log) | kRecordFlagSequence | kRecordFlagSequenceBase);
+    EXPECT_EQ(header.size, sizeof(RecordHeader) + 2);
+    std::memcpy(&header, buffer + kRecordAlignment * 2, sizeof(header));
+    EXPECT_EQ(header.type, static_cast<uint8_t>(RecordType::Log) | kRecordFlagSequence);
+    EXPECT_EQ(header.size, sizeof(RecordHeader) + 1);
+    EXPECT_EQ(buffer[kRecordAlignment * 2 + sizeof(RecordHeader)], 1);
+    EXPECT_EQ(logger.next_sequence(), 1002);
+}
+
+TEST_F(LoggerTest, SequenceBaseRestatedAfterReset) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_sequence_numbers(true);
+    logger.begin_record(Level::Info);
+    logger.end_record();
+    logger.reset();
+    logger.begin_record(Level::Info);
+    logger.end_record();
+    
+    RecordHeader header;
+    std::memcpy(&header, buffer, sizeof(header));
+    EXPECT_TRUE(header.type & kRecordFlagSequenceBase);
+    EXPECT_EQ(buffer[sizeof(RecordHeader)], 1);
+}
+
+TEST_F(LoggerTest, BufferHeaderWritten) {
+    alignas(kRecordAlignment) uint8_t large[256] = {};
+    Logger logger(large, sizeof(large));
+    logger.set_sequence_numbers(true).set_next_sequence(42).set_format_hash(0x1234);
+    logger.set_buffer_header(true);
+    EXPECT_EQ(logger.bytes_written(), sizeof(BufferHeader));
+    
+    BufferHeader header;
+    std::memcpy(&header, large, sizeof(header));
+    EXPECT_EQ(header.magic, kBufferMagic);
+    EXPECT_EQ(header.version, kBufferFormatVersion);
+    EXPECT_EQ(header.header_size, sizeof(BufferHeader));
+    EXPECT_NE(header.pid, 0u);
+    EXPECT_NE(header.tid, 0u);
+    EXPECT_NE(header.steady_ns, 0u);
+    EXPECT_NE(header.system_ns, 0u);
+    EXPECT_EQ(header.format_hash, 0x1234u);
+    EXPECT_EQ(header.first_sequence, 42u);
+    EXPECT_EQ(header.epoch, 0u);
+    
+    // The first record follows the header and still carries an absolute sequence
+    ASSERT_TRUE(logger.begin_record(Level::Info));
+    ASSERT_TRUE(logger.end_record());
+    RecordHeader record;
+    std::memcpy(&record, large + sizeof(BufferHeader), sizeof(record));
+    EXPECT_TRUE(record.type & kRecordFlagSequenceBase);
+}
+
+TEST_F(LoggerTest, BufferHeaderOnResetAndAttach) {
+    alignas(kRecordAlignment) uint8_t large[256] = {};
+    Logger logger(large, sizeof(large));
+    logger.set_buffer_header(true).set_gap_records(true);
+    
+    // Drop one record, then start a new epoch
+    logger.begin_record(Level::Info);
+    logger.log(std::string(sizeof(large), 'x'));
+    EXPECT_FALSE(logger.end_record());
+    logger.reset();
+    
+    BufferHeader header;
+    std::memcpy(&header, large, sizeof(header));
+    EXPECT_EQ(header.magic, kBufferMagic);
+    EXPECT_EQ(header.epoch, 1u);
+    
+    // The gap record comes right after the header
+    RecordHeader record;
+    std::memcpy(&record, large + sizeof(BufferHeader), sizeof(record));
+    EXPECT_EQ(record.type & kRecordTypeMask, static_cast<uint8_t>(RecordType::Gap));
+    
+    // Too small for a header: left out
+    Logger small(buffer, 16);
+    small.set_buffer_header(true);
+    EXPECT_EQ(small.bytes_written(), 0u);
+    
+    small.attach(buffer, sizeof(buffer));
+    EXPECT_EQ(small.bytes_written(), sizeof(BufferHeader));
+}
+
+TEST_F(LoggerTest, AppendSkipsBufferHeader) {
+    alignas(kRecordAlignment) uint8_t first[128] = {};
+    alignas(kRecordAlignment) uint8_t second[128] = {};
+    Logger source(first, sizeof(first));
+    source.set_buffer_header(true);
+    source.begin_record(Level::Info);
+    source.end_record();
+    
+    Logger target(second, sizeof(second));
+    EXPECT_TRUE(target.append(source));
+    EXPECT_EQ(target.bytes_written(), sizeof(RecordHeader));
+}
+
+TEST_F(LoggerTest, RecordMetadata) {
+    alignas(kRecordAlignment) uint8_t large[128] = {};
+    Logger logger(large, sizeof(large));
+    logger.set_record_metadata(true).set_sequence_numbers(true);
+    ASSERT_TRUE(logger.begin_record(Level::Warn, 3, 0xABCD));
+    ASSERT_TRUE(logger.log("x"));
+    ASSERT_TRUE(logger.end_record());
+    
+    // Header, metadata, 1-byte sequence, "x\0"
+    RecordHeader header;
+    std::memcpy(&header, large, sizeof(header));
+    EXPECT_EQ(header.size, sizeof(RecordHeader) + sizeof(RecordMetadata) + 1 + 2);
+    EXPECT_EQ(header.type & kRecordTypeMask, static_cast<uint8_t>(RecordType::Log));
+    EXPECT_TRUE(header.type & kRecordFlagMetadata);
+    EXPECT_TRUE(header.type & kRecordFlagSequence);
+    RecordMetadata metadata;
+    std::memcpy(&metadata, large + sizeof(RecordHeader), sizeof(metadata));
+    EXPECT_EQ(metadata.site, 0xABCDu);
+    EXPECT_LT(metadata.timestamp_us, 60u * 1000 * 1000);
+    EXPECT_EQ(large[sizeof(RecordHeader) + sizeof(RecordMetadata)], 0);  // sequence 0
+}
+
+namespace {
+
+struct WatermarkEvents {
+    int high = 0;
+    int low = 0;
+};
+
+void count_watermark(Logger&, bool high, void* context) {
+    auto* events = static_cast<WatermarkEvents*>(context);
+    ++(high ? events->high : events->low);
+}
+
+} // namespace
+
+TEST_F(LoggerTest, WatermarksEdgeTriggered) {
+    WatermarkEvents events;
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_watermarks(60, 20, count_watermark, &events);
+    
+    const uint8_t chunk[30] = {};
+    EXPECT_TRUE(logger.log(chunk, sizeof(chunk)));
+    EXPECT_FALSE(logger.above_high_watermark());
+    EXPECT_TRUE(logger.log(chunk, sizeof(chunk)));
+    EXPECT_TRUE(logger.above_high_watermark());
+    EXPECT_EQ(events.high, 1);
+    EXPECT_TRUE(logger.log(chunk, 10));
+    EXPECT_EQ(events.high, 1);  // fires once per crossing
+    EXPECT_FALSE(logger.has_overflowed());
+    
+    logger.reset();
+    EXPECT_FALSE(logger.above_high_watermark());
+    EXPECT_EQ(events.low, 1);
+    EXPECT_TRUE(logger.log(chunk, sizeof(chunk)));
+    EXPECT_TRUE(logger.log(chunk, sizeof(chunk)));
+    EXPECT_EQ(events.high, 2);  // re-armed by the low crossing
+}
+
+TEST_F(LoggerTest, WatermarkFlagOnly) {
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_watermarks(16, 0);
+    logger.begin_record(Level::Info);
+    logger << "0123456789";
+    EXPECT_TRUE(logger.above_high_watermark());
+    logger.end_record();
+    
+    // Stays raised until the level drops below low, here never short of empty
+    logger.reset();
+    EXPECT_TRUE(logger.above_high_watermark());
+    
+    logger.set_watermarks(kNoWatermark, 0);
+    logger << "0123456789012345678901234567890";
+    EXPECT_TRUE(logger.above_high_watermark());
+    logger.set_watermarks(kNoWatermark, 1);
+    logger.reset();
+    EXPECT_FALSE(logger.above_high_watermark());
+}
+
+TEST_F(LoggerTest, WatermarkAlreadyExceeded) {
+    WatermarkEvents events;
+    Logger logger(buffer, sizeof(buffer));
+    logger << "0123456789";
+    logger.set_watermarks(8, 4, count_watermark, &events);
+    EXPECT_TRUE(logger.above_high_watermark());
+    EXPECT_EQ(events.high, 1);
+}
+
+TEST_F(LoggerTest, WatermarkCrossedByHeaders) {
+    WatermarkEvents events;
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_watermarks(8, 4, count_watermark, &events);
+    
+    // A record header alone crosses the mark
+    logger.begin_record(Level::Info);
+    EXPECT_EQ(events.high, 1);
+    logger.end_record();
+    
+    // So does the gap record written by reset()
+    logger.set_gap_records(true);
+    const std::string big(200, 'x');
+    EXPECT_FALSE(logger.log(big));
+    logger.reset();
+    EXPECT_EQ(events.low, 1);
+    EXPECT_GE(logger.bytes_written(), 8u);
+    EXPECT_TRUE(logger.above_high_watermark());
+    EXPECT_EQ(events.high, 2);
+}
@@ -0,0 +1,185 @@
+#include "log_buffer/site_sketch.hpp"
+#include "log_buffer/decoder.hpp"
+#include "log_buffer/drain.hpp"
+#include <gtest/gtest.h>
+#include <map>
+#include <vector>
+
+using namespace log_buffer;
+using namespace std::chrono_literals;
+
+TEST(SiteSketchTest, FindsHeavyHitters) {
+    SiteSketch sketch(256, 4, 4);
+    std::map<uint32_t, uint64_t> truth;
+    for (uint32_t i = 0; i < 20000; ++i) {
+        // Sites 1..3 are noisy; 1000 others log once or twice each
+        const uint32_t key = i % 10 == 0 ? 1 : i % 10 == 1 ? 2 : i % 20 == 2 ? 3 : 100 + i % 1000;
+        sketch.add(key);
+        ++truth[key];
+    }
+    EXPECT_EQ(sketch.total(), 20000u);
+
+    SiteCount top[4];
+    ASSERT_EQ(sketch.top(top, 4), 4u);
+    EXPECT_EQ(top[0].key, 1u);
+    EXPECT_EQ(top[1].key, 2u);
+    EXPECT_EQ(top[2].key, 3u);
+    for (const auto& entry : truth) {
+        EXPECT_GE(sketch.estimate(entry.first), entry.second);
+    }
+}
+
+TEST(SiteSketchTest, WeightsAndClear) {
+    SiteSketch sketch;
+    sketch.add(7, 100);
+    sketch.add(8, 5);
+    sketch.add(7, 20);
+    EXPECT_EQ(sketch.estimate(7), 120u);
+    EXPECT_EQ(sketch.estimate(8), 5u);
+    EXPECT_EQ(sketch.total(), 125u);
+
+    sketch.clear();
+    EXPECT_EQ(sketch.total(), 0u);
+    EXPECT_EQ(sketch.estimate(7), 0u);
+    SiteCount top[8];
+    EXPECT_EQ(sketch.top(top, 8), 0u);
+}
+
+TEST(SiteSketchTest, AddBufferWeightsBySite) {
+    uint8_t buffer[1024];
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_buffer_header(true).set_record_metadata(true);
+    for (int i = 0; i < 3; ++i) {
+        logger.begin_record(Level::Info, 1, 0xA1);
+        logger << "a fairly long message from the noisy site";
+        logger.end_record();
+    }
+    logger.begin_record(Level::Info, 1, 0xB2);
+    logger << "quiet";
+    logger.end_record();
+
+    SiteSketch sketch;
+    sketch.add_buffer(logger.data(), logger.bytes_written());
+    SiteCount top[2];
+    ASSERT_EQ(sketch.top(top, 2), 2u);
+    EXPECT_EQ(top[0].key, 0xA1u);
+    EXPECT_EQ(top[1].key, 0xB2u);
+
+    RecordReader reader(logger);
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(top[0].count, 3 * record.size);
+}
+
+TEST(SiteSketchTest, EmitAndDecode) {
+    SiteSketch sketch(1024, 4, 3);
+    sketch.add(10, 50);
+    sketch.add(20, 500);
+    sketch.add(30, 5);
+    sketch.add(40, 1);  // displaces nothing heavier
+
+    uint8_t buffer[256];
+    Logger logger(buffer, sizeof(buffer));
+    ASSERT_TRUE(sketch.emit(logger, Level::Warn, 9));
+
+    RecordReader reader(logger);
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, RecordType::SiteStats);
+    EXPECT_EQ(record.level, Level::Warn);
+    EXPECT_EQ(record.tag, 9);
+
+    SiteCount top[8];
+    std::size_t count = 0;
+    uint64_t total = 0;
+    ASSERT_TRUE(decode_site_stats(record, top, 8, count, total));
+    EXPECT_EQ(total, 556u);
+    ASSERT_EQ(count, 3u);
+    EXPECT_EQ(top[0].key, 20u);
+    EXPECT_EQ(top[0].count, 500u);
+    EXPECT_EQ(top[1].key, 10u);
+    EXPECT_EQ(top[2].key, 30u);
+
+    // Fewer slots than entries: the heaviest are kept
+    ASSERT_TRUE(decode_site_stats(record, top, 1, count, total));
+    EXPECT_EQ(count, 1u);
+    EXPECT_EQ(top[0].key, 20u);
+}
+
+TEST(SiteSketchTest, EmitFailsInsideRecordOrWhenFull) {
+    SiteSketch sketch;
+    sketch.add(1);
+    uint8_t buffer[64];
+    Logger logger(buffer, sizeof(buffer));
+    logger.begin_record(Level::Info, 0);
+    EXPECT_FALSE(sketch.emit(logger));
+    logger.end_record();
+
+    Logger tiny(buffer, 8);
+    EXPECT_FALSE(sketch.emit(tiny));
+}
+
+TEST(SiteSketchTest, LoggerCountsDroppedRecords) {
+    uint8_t buffer[64];
+    Logger logger(buffer, sizeof(buffer));
+    SiteSketch drops;
+    logger.set_drop_sketch(&drops);
+
+    logger.begin_record(Level::Info, 5);
+    logger << "this payload is far too long to fit in a sixty-four byte buffer";
+    EXPECT_FALSE(logger.end_record());
+    logger.begin_record(Level::Info, 5);
+    logger << "so is this one, which is also much longer than the buffer itself";
+    EXPECT_FALSE(logger.end_record());
+    logger.begin_record(Level::Info, 6);
+    logger << "fits";
+    EXPECT_TRUE(logger.end_record());
+
+    EXPECT_EQ(drops.estimate(5), 2u);
+    EXPECT_EQ(drops.estimate(6), 0u);
+
+    // With metadata the site is the key
+    logger.reset();
+    logger.set_record_metadata(true);
+    drops.clear();
+    logger.begin_record(Level::Info, 5, 77);
+    logger << "this payload is far too long to fit in a sixty-four byte buffer";
+    EXPECT_FALSE(logger.end_record());
+    EXPECT_EQ(drops.estimate(77), 1u);
+}
+
+TEST(SiteSketchTest, DrainerEmitsSiteStats) {
+    BufferPool pool(2, 512);
+    std::vector<std::vector<uint8_t>> chunks;
+    Drainer drainer(pool, [&](const uint8_t* data, std::size_t size) { chunks.emplace_back(data, data + size); });
+    SiteSketch sketch;
+    drainer.set_site_sketch(&sketch, 0ns);
+
+    Logger logger(nullptr, 0);
+    ASSERT_TRUE(pool.acquire(logger));
+    for (uint16_t tag : {3, 3, 3, 4}) {
+        logger.begin_record(Level::Info, tag);
+        logger << "payload";
+        logger.end_record();
+    }
+    pool.seal(logger);
+    EXPECT_EQ(drainer.drain(), 1u);
+
+    ASSERT_EQ(chunks.size(), 2u);  // the buffer, then the stats
+    RecordReader reader(chunks[1].data(), chunks[1].size());
+    RecordView record;
+    ASSERT_TRUE(reader.next(record));
+    SiteCount top[8];
+    std::size_t count = 0;
+    uint64_t total = 0;
+    ASSERT_TRUE(decode_site_stats(record, top, 8, count, total));
+    ASSERT_EQ(count, 2u);
+    EXPECT_EQ(top[0].key, 3u);
+    EXPECT_EQ(top[1].key, 4u);
+    EXPECT_EQ(total, chunks[0].size());
+    EXPECT_EQ(sketch.total(), 0u);  // cleared for the next interval
+
+    // Nothing drained since: no empty stats record
+    drainer.drain();
+    EXPECT_EQ(chunks.size(), 2u);
+}
@@ -0,0 +1,148 @@
+#include "log_buffer/time_index.hpp"
+#include "log_buffer/block_summary.hpp"
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace log_buffer;
+
+namespace {
+
+constexpr uint64_t kSecond = 1000000000;
+
+/// A buffer of timed records "block <b> record <i>" whose header claims wall time b seconds.
+std::vector<uint8_t> make_block(int b, int records) {
+    std::vector<uint8_t> buffer(4096);
+    Logger logger(buffer.data(), buffer.size());
+    logger.set_buffer_header(true).set_record_metadata(true);
+    for (int i = 0; i < records; ++i) {
+        logger.begin_record(Level::Info, 1, 10);
+        logger << "block" << b << "record" << i;
+        logger.end_record();
+    }
+    buffer.resize(logger.bytes_written());
+    // Pin the wall clock so block b spans [b s, b s + a few us]
+    const uint64_t system_ns = static_cast<uint64_t>(b) * kSecond;
+    std::memcpy(buffer.data() + offsetof(BufferHeader, system_ns), &system_ns, sizeof(system_ns));
+    return buffer;
+}
+
+std::string temp_path() {
+    char path[] = "/tmp/log_buffer_indexXXXXXX";
+    const int fd = ::mkstemp(path);
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    return path;
+}
+
+} // namespace
+
+TEST(TimeIndexTest, BlockTimeRange) {
+    const std::vector<uint8_t> block = make_block(5, 3);
+    uint64_t first = 0;
+    uint64_t last = 0;
+    ASSERT_TRUE(block_time_range(block.data(), block.size(), first, last));
+    EXPECT_GE(first, 5 * kSecond);
+    EXPECT_LE(first, last);
+    EXPECT_LT(last, 6 * kSecond);
+
+    // Without metadata there is nothing to index
+    uint8_t buffer[256];
+    Logger logger(buffer, sizeof(buffer));
+    logger.set_buffer_header(true);
+    logger.begin_record(Level::Info, 1);
+    logger << "untimed";
+    logger.end_record();
+    EXPECT_FALSE(block_time_range(logger.data(), logger.bytes_written(), first, last));
+}
+
+TEST(TimeIndexTest, WriteLoadAndExtract) {
+    const std::string index_path = temp_path();
+    std::vector<uint8_t> dump;
+    TimeIndexWriter writer;
+    ASSERT_TRUE(writer.open(index_path.c_str()));
+    BlockSummarizer summarizer;
+    // Two producers: blocks reach the dump slightly out of time order
+    for (int b : {0, 2, 1, 3, 5, 4, 6, 7, 9, 8}) {
+        const std::vector<uint8_t> block = make_block(b * 10, 4);
+        summarizer.summarize(block.data(), block.size());  // untimed chunk: offset only
+        for (const auto& chunk : {std::vector<uint8_t>(summarizer.data(), summarizer.data() + summarizer.size()),
+                                  block}) {
+            ASSERT_TRUE(writer.add(chunk.data(), chunk.size()));
+            dump.insert(dump.end(), chunk.begin(), chunk.end());
+        }
+    }
+    EXPECT_EQ(writer.offset(), dump.size());
+    writer.close();
+
+    TimeIndex index;
+    ASSERT_TRUE(index.load(index_path.c_str()));
+    ::unlink(index_path.c_str());
+    ASSERT_EQ(index.entries().size(), 10u);
+    for (std::size_t i = 1; i < index.entries().size(); ++i) {
+        EXPECT_LE(index.entries()[i - 1].first_ns, index.entries()[i].first_ns);
+    }
+
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    index.candidates(30 * kSecond, 50 * kSecond + kSecond / 2, begin, end);
+    EXPECT_EQ(end - begin, 3u);
+
+    std::vector<std::string> found;
+    const TimeRangeStats stats = index.extract(dump.data(), dump.size(), 30 * kSecond, 50 * kSecond + kSecond / 2,
+                                               [&](const RecordView& record, uint64_t time_ns) {
+                                                   EXPECT_GE(time_ns, 30 * kSecond);
+                                                   std::string text;
+                                                   format_text(record.data, record.size, text);
+                                                   found.push_back(text);
+                                               });
+    EXPECT_EQ(stats.blocks, 3u);
+    EXPECT_EQ(stats.matches, 12u);
+    ASSERT_EQ(found.size(), 12u);
+    EXPECT_NE(found.front().find("block 30 record 0"), std::string::npos);
+    EXPECT_NE(found.back().find("block 50 record 3"), std::string::npos);
+
+    // Ranges between or beyond the blocks read nothing
+    EXPECT_EQ(index.extract(dump.data(), dump.size(), 31 * kSecond, 39 * kSecond, [](const RecordView&, uint64_t) {})
+                  .blocks, 0u);
+    EXPECT_EQ(index.extract(dump.data(), dump.size(), 100 * kSecond, 200 * kSecond,
+                            [](const RecordView&, uint64_t) {}).blocks, 0u);
+
+    // Entries past the end of a truncated dump are ignored
+    EXPECT_EQ(index.extract(dump.data(), dump.size() / 2, 0, UINT64_MAX, [](const RecordView&, uint64_t) {})
+                  .blocks, 5u);
+}
+
+TEST(TimeIndexTest, OverlappingBlocks) {
+    // A long block overlapping later ones stays a candidate through the running maximum
+    TimeIndex index;
+    index.assign({{10, 100, 0, 1}, {20, 30, 1, 1}, {40, 50, 2, 1}, {60, 70, 3, 1}});
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    index.candidates(80, 90, begin, end);
+    EXPECT_EQ(begin, 0u);
+    EXPECT_EQ(end, 4u);
+    index.candidates(5, 15, begin, end);
+    EXPECT_EQ(begin, 0u);
+    EXPECT_EQ(end, 1u);
+    index.candidates(101, 200, begin, end);
+    EXPECT_EQ(begin, end);
+}
+
+TEST(TimeIndexTest, LoadRejectsOtherFiles) {
+    TimeIndex index;
+    EXPECT_FALSE(index.load("/nonexistent/log_buffer_index"));
+
+    const std::string path = temp_path();
+    FILE* file = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    std::fputs("not an index, just some text", file);
+    std::fclose(file);
+    EXPECT_FALSE(index.load(path.c_str()));
+    ::unlink(path.c_str());
+}
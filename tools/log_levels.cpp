@@ -0,0 +1,132 @@
+// Inspect or change a shared-memory level table of a running process.
+//
+//   log_levels <name> create                 create the table if missing
+//   log_levels <name> show [tag]             print non-default tags (or one tag)
+//   log_levels <name> set <tag|all> <level>  enable <level> and above
+//   log_levels <name> off <tag|all>          disable every level
+//   log_levels <name> remove                 delete the table
+
+#include "log_buffer/level_table.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace log_buffer;
+
+namespace {
+
+int usage() {
+    std::fprintf(stderr,
+                 "usage: log_levels <name> create\n"
+                 "       log_levels <name> show [tag]\n"
+                 "       log_levels <name> set <tag|all> <trace|debug|info|warn|error|fatal>\n"
+                 "       log_levels <name> off <tag|all>\n"
+                 "       log_levels <name> remove\n");
+    return 2;
+}
+
+bool parse_level(const char* text, Level& level) {
+    for (std::size_t i = 0; i < kLevelCount; ++i) {
+        if (std::strcmp(text, level_name(static_cast<Level>(i))) == 0) {
+            level = static_cast<Level>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_tag(const char* text, long& tag) {
+    if (std::strcmp(text, "all") == 0) {
+        tag = -1;
+        return true;
+    }
+    char* end = nullptr;
+    tag = std::strtol(text, &end, 0);
+    return *text != '\0' && *end == '\0' && tag >= 0 && tag < static_cast<long>(kLevelTableTags);
+}
+
+void print_tag(const LevelTable& table, uint16_t tag) {
+    std::printf("%5u:", static_cast<unsigned>(tag));
+    const uint8_t mask = table.levels(tag);
+    for (std::size_t i = 0; i < kLevelCount; ++i) {
+        if (mask & (1u << i)) {
+            std::printf(" %s", level_name(static_cast<Level>(i)));
+        }
+    }
+    std::printf("%s\n", mask == 0 ? " off" : "");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        return usage();
+    }
+    const char* name = argv[1];
+    const char* command = argv[2];
+    
+    if (std::strcmp(command, "remove") == 0) {
+        if (!LevelTable::remove(name)) {
+            std::perror("log_levels: remove");
+            return 1;
+        }
+        return 0;
+    }
+    
+    LevelTable table;
+    if (!table.open(name, std::strcmp(command, "create") == 0)) {
+        std::fprintf(stderr, "log_levels: cannot open level table %s\n", name);
+        return 1;
+    }
+    
+    if (std::strcmp(command, "create") == 0) {
+        return 0;
+    }
+    if (std::strcmp(command, "show") == 0) {
+        long tag = -1;
+        if (argc > 3 && (!parse_tag(argv[3], tag) || tag < 0)) {
+            return usage();
+        }
+        if (tag >= 0) {
+            print_tag(table, static_cast<uint16_t>(tag));
+            return 0;
+        }
+        std::printf("default:");
+        for (std::size_t i = 0; i < kLevelCount; ++i) {
+            if (kDefaultLevelMask & (1u << i)) {
+                std::printf(" %s", level_name(static_cast<Level>(i)));
+            }
+        }
+        std::printf("\n");
+        for (std::size_t t = 0; t < kLevelTableTags; ++t) {
+            if (table.levels(static_cast<uint16_t>(t)) != kDefaultLevelMask) {
+                print_tag(table, static_cast<uint16_t>(t));
+            }
+        }
+        return 0;
+    }
+    
+    uint8_t mask = 0;
+    long tag = 0;
+    if (std::strcmp(command, "set") == 0 && argc == 5) {
+        Level level;
+        if (!parse_tag(argv[3], tag) || !parse_level(argv[4], level)) {
+            return usage();
+        }
+        mask = levels_from(level);
+    } else if (std::strcmp(command, "off") == 0 && argc == 4) {
+        if (!parse_tag(argv[3], tag)) {
+            return usage();
+        }
+    } else {
+        return usage();
+    }
+    
+    if (tag < 0) {
+        table.set_all(mask);
+    } else {
+        table.set_levels(static_cast<uint16_t>(tag), mask);
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Print the records of a dump written between two wall-clock times.
+//
+//   log_query <dump> <index> <from> <to> [--prefixed] [--stats]
+//
+// <index> is the file written by TimeIndexWriter next to the dump; only the
+// blocks it places in the range are read. Times are Unix seconds with an
+// optional fraction (e.g. 1760000000.25), both ends inclusive. Each line is
+// the record's time followed by its text. --prefixed reads length-prefixed
+// string fields, --stats prints how much was read to stderr.
+
+#include "log_buffer/time_index.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace log_buffer;
+
+namespace {
+
+int usage() {
+    std::fprintf(stderr, "usage: log_query <dump> <index> <from> <to> [--prefixed] [--stats]\n");
+    return 2;
+}
+
+bool parse_time(const char* text, uint64_t& time_ns) {
+    uint64_t seconds = 0;
+    uint64_t fraction = 0;
+    uint64_t scale = 1000000000;
+    const char* p = text;
+    for (; *p >= '0' && *p <= '9'; ++p) {
+        if (seconds > UINT64_MAX / 1000000000 / 10) {
+            return false;
+        }
+        seconds = seconds * 10 + static_cast<uint64_t>(*p - '0');
+    }
+    if (p == text) {
+        return false;
+    }
+    if (*p == '.') {
+        for (++p; *p >= '0' && *p <= '9'; ++p) {
+            if (scale > 1) {
+                scale /= 10;
+                fraction += static_cast<uint64_t>(*p - '0') * scale;
+            }
+        }
+    }
+    time_ns = seconds * 1000000000 + fraction;
+    return *p == '\0';
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 5) {
+        return usage();
+    }
+    uint64_t from_ns = 0;
+    uint64_t to_ns = 0;
+    if (!parse_time(argv[3], from_ns) || !parse_time(argv[4], to_ns)) {
+        return usage();
+    }
+    StringFormat format = StringFormat::NulTerminated;
+    bool print_stats = false;
+    for (int i = 5; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--prefixed") == 0) {
+            format = StringFormat::LengthPrefixed;
+        } else if (std::strcmp(argv[i], "--stats") == 0) {
+            print_stats = true;
+        } else {
+            return usage();
+        }
+    }
+
+    TimeIndex index;
+    if (!index.load(argv[2])) {
+        std::fprintf(stderr, "log_query: cannot read time index %s\n", argv[2]);
+        return 1;
+    }
+    MappedDump dump;
+    if (!dump.open(argv[1])) {
+        std::fprintf(stderr, "log_query: cannot map %s\n", argv[1]);
+        return 1;
+    }
+    dump.advise_random();
+
+    std::string line;
+    const TimeRangeStats stats =
+        index.extract(dump.data(), dump.size(), from_ns, to_ns, [&](const RecordView& record, uint64_t time_ns) {
+            char stamp[32];
+            std::snprintf(stamp, sizeof(stamp), "%llu.%09llu ",
+                          static_cast<unsigned long long>(time_ns / 1000000000),
+                          static_cast<unsigned long long>(time_ns % 1000000000));
+            line = stamp;
+            format_text(record.data, record.size, line, format);
+            std::fwrite(line.data(), 1, line.size(), stdout);
+        });
+    if (print_stats) {
+        std::fprintf(stderr, "index entries %zu, blocks read %llu (%llu of %zu bytes), records %llu, in range %llu\n",
+                     index.entries().size(), static_cast<unsigned long long>(stats.blocks),
+                     static_cast<unsigned long long>(stats.bytes), dump.size(),
+                     static_cast<unsigned long long>(stats.records), static_cast<unsigned long long>(stats.matches));
+    }
+    return 0;
+}
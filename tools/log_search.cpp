@@ -0,0 +1,71 @@
+// Find the records of a dump that contain every token of a query.
+//
+//   log_search <dump> <query> [--prefixed] [--stats]
+//
+// The dump must have been written with block summaries
+// (Drainer::set_block_summarizer()); blocks whose filter rules the query out
+// are skipped without being read. Tokens are runs of letters, digits, '_'
+// and '-', matched whole. --prefixed reads length-prefixed string fields,
+// --stats prints how many blocks were skipped to stderr.
+
+#include "log_buffer/block_summary.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace log_buffer;
+
+namespace {
+
+int usage() {
+    std::fprintf(stderr, "usage: log_search <dump> <query> [--prefixed] [--stats]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        return usage();
+    }
+    StringFormat format = StringFormat::NulTerminated;
+    bool print_stats = false;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--prefixed") == 0) {
+            format = StringFormat::LengthPrefixed;
+        } else if (std::strcmp(argv[i], "--stats") == 0) {
+            print_stats = true;
+        } else {
+            return usage();
+        }
+    }
+    bool has_token = false;
+    for_each_token(argv[2], [&](std::string_view) { has_token = true; });
+    if (!has_token) {
+        std::fprintf(stderr, "log_search: query has no tokens\n");
+        return 2;
+    }
+
+    MappedDump dump;
+    if (!dump.open(argv[1])) {
+        std::fprintf(stderr, "log_search: cannot map %s\n", argv[1]);
+        return 1;
+    }
+    dump.advise_random();
+
+    std::string line;
+    const BlockSearchStats stats =
+        search_blocks(dump.data(), dump.size(), argv[2], format, [&](const RecordView& record) {
+            line.clear();
+            format_text(record.data, record.size, line, format);
+            std::fwrite(line.data(), 1, line.size(), stdout);
+        });
+    if (print_stats) {
+        std::fprintf(stderr, "blocks %llu, skipped %llu (%llu bytes), records decoded %llu, matches %llu\n",
+                     static_cast<unsigned long long>(stats.blocks), static_cast<unsigned long long>(stats.skipped),
+                     static_cast<unsigned long long>(stats.bytes_skipped),
+                     static_cast<unsigned long long>(stats.records), static_cast<unsigned long long>(stats.matches));
+    }
+    return stats.matches != 0 ? 0 : 1;
+}